@@ -13,13 +13,210 @@
 
 
 #include <stdint.h>
-#include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <math.h>
 #include "luminox.h"
 
+// the driver never allocates, any use of the heap is a compile error
+#if defined(__GNUC__)
+#pragma GCC poison malloc calloc realloc free
+#endif
+
 extern volatile bool luminox_complete_uart_rx;
 
+#ifdef LUMINOX_PROFILING
+/*
+    @brief Function for adding one timed call to the profile of a driver entry point
+
+    @param[in] id Entry point that was timed
+
+    @param[in] start Cycle count read when the entry point was called
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+static void luminox_profile_record(luminox_profile_id_t id, uint32_t start, luminox_handler_t * luminox_handler) {
+    if(luminox_handler->luminox_get_cycles == NULL) {
+        return;
+    }
+    uint32_t cycles = luminox_handler->luminox_get_cycles() - start; // unsigned math handles counter wrap
+    luminox_profile_stat_t * stat = &luminox_handler->profile[id];
+    if(stat->count == 0 || cycles < stat->min) {
+        stat->min = cycles;
+    }
+    if(cycles > stat->max) {
+        stat->max = cycles;
+    }
+    stat->total += cycles;
+    stat->count++;
+}
+
+// time the enclosing function, every return must be preceded by LUMINOX_PROFILE_EXIT
+#define LUMINOX_PROFILE_ENTER() \
+    uint32_t profile_start = (luminox_handler->luminox_get_cycles != NULL) ? luminox_handler->luminox_get_cycles() : 0
+#define LUMINOX_PROFILE_EXIT(id) luminox_profile_record((id), profile_start, luminox_handler)
+#else
+#define LUMINOX_PROFILE_ENTER()
+#define LUMINOX_PROFILE_EXIT(id)
+#endif
+
+/*
+    @brief Function for getting the current time of the handler
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return Time in milliseconds, the replay clock while replaying, 0 if there is no time source
+*/
+static uint32_t luminox_now(luminox_handler_t * luminox_handler) {
+    if(luminox_handler->replay_active) {
+        return luminox_handler->virtual_time;
+    }
+    if(luminox_handler->luminox_get_time != NULL) {
+        return luminox_handler->luminox_get_time();
+    }
+    return 0;
+}
+
+/*
+    @brief Function for passing a UART transfer to the capture callback
+
+    @param[in] direction Direction of the transfer
+
+    @param[in] data Bytes of the transfer
+
+    @param[in] size Number of bytes
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+static void luminox_capture(luminox_capture_dir_t direction, const uint8_t * data, uint8_t size, luminox_handler_t * luminox_handler) {
+    if(luminox_handler->luminox_capture == NULL || luminox_handler->replay_active) {
+        return;
+    }
+    luminox_capture_record_t record = {
+        .timestamp = luminox_now(luminox_handler),
+        .direction = direction,
+        .size = size,
+        .data = data
+    };
+    luminox_handler->luminox_capture(&record, luminox_handler->capture_context);
+}
+
+/*
+    @brief Function for moving the bus utilisation window up to the current time
+
+    @note Clears every slot that was skipped since the last transfer, at most LUMINOX_BUS_WINDOW_SLOTS
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return Slot for the current time
+*/
+static luminox_bus_slot_t * luminox_bus_slot(luminox_handler_t * luminox_handler) {
+    uint32_t slot = luminox_now(luminox_handler) / LUMINOX_BUS_SLOT_MS;
+    uint32_t elapsed = slot - luminox_handler->bus_slot;
+    if(elapsed > LUMINOX_BUS_WINDOW_SLOTS) {
+        elapsed = LUMINOX_BUS_WINDOW_SLOTS;
+    }
+    for(uint32_t i = 1; i <= elapsed; i++) {
+        luminox_bus_slot_t * cleared = &luminox_handler->bus_slots[(luminox_handler->bus_slot + i) % LUMINOX_BUS_WINDOW_SLOTS];
+        cleared->tx_bytes = 0;
+        cleared->rx_bytes = 0;
+    }
+    if(elapsed > 0) {
+        uint32_t used = luminox_handler->bus_slots_used + elapsed; // up to 254 + 255, clamp before it is narrowed
+        if(used > LUMINOX_BUS_WINDOW_SLOTS - 1) {
+            used = LUMINOX_BUS_WINDOW_SLOTS - 1; // the current slot is the last of the window
+        }
+        luminox_handler->bus_slots_used = (uint8_t)used;
+    }
+    luminox_handler->bus_slot = slot;
+    return &luminox_handler->bus_slots[slot % LUMINOX_BUS_WINDOW_SLOTS];
+}
+
+/*
+    @brief Function for passing a trace event to the trace callback
+
+    @param[in] event Event that just happened
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+static void luminox_trace(luminox_trace_event_t event, luminox_handler_t * luminox_handler) {
+    if(luminox_handler->luminox_trace != NULL) {
+        luminox_handler->luminox_trace(event, luminox_handler->trace_context);
+    }
+}
+
+/*
+    @brief Function for getting the time bytes take on the line
+
+    @param[in] bytes Number of bytes
+
+    @return Time to send the bytes at LUMINOX_BAUDRATE in milliseconds, rounded to the nearest
+*/
+static uint32_t luminox_transit_time(uint32_t bytes) {
+    return (bytes * LUMINOX_BITS_PER_BYTE * 1000 + LUMINOX_BAUDRATE / 2) / LUMINOX_BAUDRATE;
+}
+
+/*
+    @brief Function for getting the time the sensor started sending bytes that were received at a given time
+
+    @param[in] time Time the bytes were received
+
+    @param[in] bytes Number of bytes
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return time minus the transit time of the bytes, clamped at 0, or 0 without a time source
+*/
+static uint32_t luminox_back_date(uint32_t time, uint32_t bytes, luminox_handler_t * luminox_handler) {
+    uint32_t transit = luminox_transit_time(bytes);
+    if(!luminox_handler->replay_active && luminox_handler->luminox_get_time == NULL) {
+        return 0;
+    }
+    return (time > transit) ? time - transit : 0;
+}
+
+/*
+    @brief Function for storing a complete response in luminox_data
+
+    @param[in] p_response Pointer to the response
+
+    @param[in] size Size of the response in bytes
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+static void luminox_store_response(const uint8_t * p_response, uint8_t size, luminox_handler_t * luminox_handler) {
+    luminox_capture(LUMINOX_CAPTURE_RX, p_response, size, luminox_handler);
+    luminox_bus_slot(luminox_handler)->rx_bytes += size;
+    luminox_handler->rx_bytes_total += size;
+    if(size > UART_RX_BUF_SIZE) {
+        size = UART_RX_BUF_SIZE; // anything past the buffer can't hold a valid response
+    }
+    memcpy(luminox_handler->luminox_data, p_response, size);
+    luminox_handler->luminox_data_size = size;
+}
+
+/*
+    @brief Function for transmitting a request to the sensor
+
+    @note Starts the response latency measurement and captures the request
+
+    @param[in] request Request to transmit
+
+    @param[in] size Size of the request in bytes
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+static void luminox_transmit(unsigned char * request, uint8_t size, luminox_handler_t * luminox_handler) {
+    luminox_handler->request_time = luminox_now(luminox_handler);
+    luminox_handler->request_pending = true;
+    luminox_capture(LUMINOX_CAPTURE_TX, request, size, luminox_handler);
+    luminox_bus_slot(luminox_handler)->tx_bytes += size;
+    luminox_handler->tx_bytes_total += size;
+    luminox_trace(LUMINOX_TRACE_TX_START, luminox_handler);
+    luminox_handler->luminox_tx(request, size);
+    luminox_trace(LUMINOX_TRACE_TX_END, luminox_handler);
+}
+
 /*
     @brief Function for setting the output mode of the luminox sensor
 
@@ -32,6 +229,7 @@ extern volatile bool luminox_complete_uart_rx;
     @return luminox_retcode_t Either success or one of the error codes
 */
 luminox_retcode_t luminox_set_ouput_mode(luminox_mode_t mode, luminox_handler_t * luminox_handler) {
+    LUMINOX_PROFILE_ENTER();
     unsigned char mode_msg[] = "M x\r\n";
     // set command to given mode
     switch(mode) {
@@ -48,15 +246,17 @@ luminox_retcode_t luminox_set_ouput_mode(luminox_mode_t mode, luminox_handler_t
 #ifdef DEBUG_OUTPUT
 	    NRF_LOG_INFO("Invalid Mode");
 #endif
+	    LUMINOX_PROFILE_EXIT(LUMINOX_PROFILE_SET_OUTPUT_MODE);
 	    return LUMINOX_ERR_INVALID_MODE;
     }
     
 
-    luminox_handler->luminox_tx(mode_msg, 5); // transmit the message
+    luminox_transmit(mode_msg, 5, luminox_handler); // transmit the message
 
     //luminox_wait_for_response(luminox_handler);
     luminox_process_response(luminox_handler);
 
+    LUMINOX_PROFILE_EXIT(LUMINOX_PROFILE_SET_OUTPUT_MODE);
     return luminox_handler->err_code;
 }
 
@@ -81,26 +281,28 @@ luminox_mode_t luminox_get_output_mode(luminox_handler_t * luminox_handler) {
     @return luminox_retcode_t Either success or one of the error codes
 */
 luminox_retcode_t luminox_request_ppO2(luminox_handler_t * luminox_handler) {
+    LUMINOX_PROFILE_ENTER();
     unsigned char req[] = "O\r\n";
-    luminox_handler->luminox_tx(req, 3); // transmit the request
+    luminox_transmit(req, 3, luminox_handler); // transmit the request
 
      //luminox_wait_for_response(luminox_handler);
      luminox_process_response(luminox_handler);
 
+    LUMINOX_PROFILE_EXIT(LUMINOX_PROFILE_REQUEST_PPO2);
     return luminox_handler->err_code;
 }
 
 /*
     @brief Function for getting the current ppO2 value
 
-    @note This function returns whatever is stored in the current_ppO2 variable, which may be out of date. Call luminox_request_ppO2() first.
+    @note This function returns whatever is stored in the sample.ppo2 variable, which may be out of date. Call luminox_request_ppO2() first.
 
     @param[in] luminox_handler Pointer of library handler
 
     @return Floating point integer of the ppO2 value
 */
 float luminox_get_ppO2(luminox_handler_t * luminox_handler) {
-    return luminox_handler->current_ppO2;
+    return luminox_handler->sample.ppo2;
 }
 
 /*
@@ -113,26 +315,28 @@ float luminox_get_ppO2(luminox_handler_t * luminox_handler) {
     @return luminox_retcode_t Either success or one of the error codes
 */
 luminox_retcode_t luminox_request_O2(luminox_handler_t * luminox_handler) {
+    LUMINOX_PROFILE_ENTER();
     unsigned char req[] = "%\r\n";
-    luminox_handler->luminox_tx(req, 3); // transmit the request
+    luminox_transmit(req, 3, luminox_handler); // transmit the request
 
      //luminox_wait_for_response(luminox_handler);
      luminox_process_response(luminox_handler);
 
+    LUMINOX_PROFILE_EXIT(LUMINOX_PROFILE_REQUEST_O2);
     return luminox_handler->err_code;
 }
 
 /*
     @brief Function for getting the current O2 value
 
-    @note This function returns whatever is stored in the current_O2 variable, which may be out of date. Call luminox_request_O2() first.
+    @note This function returns whatever is stored in the sample.o2 variable, which may be out of date. Call luminox_request_O2() first.
 
     @param[in] luminox_handler Pointer of library handler
 
     @return Floating point integer of the O2 value
 */
 float luminox_get_O2(luminox_handler_t * luminox_handler) {
-    return luminox_handler->current_O2;
+    return luminox_handler->sample.o2;
 }
 
 /*
@@ -145,26 +349,28 @@ float luminox_get_O2(luminox_handler_t * luminox_handler) {
     @return luminox_retcode_t Either success or one of the error codes
 */
 luminox_retcode_t luminox_request_temp(luminox_handler_t * luminox_handler) {
+    LUMINOX_PROFILE_ENTER();
     unsigned char req[] = "T\r\n";
-    luminox_handler->luminox_tx(req, 3); // transmit the request
+    luminox_transmit(req, 3, luminox_handler); // transmit the request
 
      //luminox_wait_for_response(luminox_handler);
      luminox_process_response(luminox_handler);
 
+    LUMINOX_PROFILE_EXIT(LUMINOX_PROFILE_REQUEST_TEMP);
     return luminox_handler->err_code;
 }
 
 /*
     @brief Function for getting the current temp value
 
-    @note This function returns whatever is stored in the current_temp variable, which may be out of date. Call luminox_request_temp() first.
+    @note This function returns whatever is stored in the sample.temp variable, which may be out of date. Call luminox_request_temp() first.
 
     @param[in] luminox_handler Pointer of library handler
 
     @return Floating point integer of the temp value
 */
 float luminox_get_temp(luminox_handler_t * luminox_handler) {
-    return luminox_handler->current_temp;
+    return luminox_handler->sample.temp;
 }
 
 /*
@@ -179,26 +385,101 @@ float luminox_get_temp(luminox_handler_t * luminox_handler) {
     @return luminox_retcode_t Either success or one of the error codes
 */
 luminox_retcode_t luminox_request_barometric_pressure(luminox_handler_t * luminox_handler) {
+    LUMINOX_PROFILE_ENTER();
     unsigned char req[] = "P\r\n";
-    luminox_handler->luminox_tx(req, 3); // transmit the request
+    luminox_transmit(req, 3, luminox_handler); // transmit the request
 
      //luminox_wait_for_response(luminox_handler);
      luminox_process_response(luminox_handler);
 
+    LUMINOX_PROFILE_EXIT(LUMINOX_PROFILE_REQUEST_BAROMETRIC_PRESSURE);
     return luminox_handler->err_code;
 }
 
 /*
     @brief Function for getting the current barometric pressure value
 
-    @note This function returns whatever is stored in the current_barometric_pressure variable, which may be out of date. Call luminox_request_barometric_pressure() first.
+    @note This function returns whatever is stored in the sample.barometric_pressure variable, which may be out of date. Call luminox_request_barometric_pressure() first.
 
     @param[in] luminox_handler Pointer of library handler
 
     @return Floating point integer of the barometric pressure value
 */
 float luminox_get_barometric_pressure(luminox_handler_t * luminox_handler) {
-    return luminox_handler->current_barometric_pressure;
+    return luminox_handler->sample.barometric_pressure;
+}
+
+/*
+    @brief Function for checking if the sensor reported a barometric pressure
+
+    @note Sensors without a barometric pressure sensor answer "------", which leaves this false
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return true if the last barometric pressure response held a value
+*/
+bool luminox_barometric_pressure_valid(luminox_handler_t * luminox_handler) {
+    return luminox_handler->barometric_pressure_valid;
+}
+
+/*
+    @brief Function for getting the variant of the sensor detected by luminox_init()
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return luminox_variant_t with or without barometric pressure sensor
+*/
+luminox_variant_t luminox_get_variant(luminox_handler_t * luminox_handler) {
+    return luminox_handler->variant;
+}
+
+/*
+    @brief Function for setting a barometric pressure measured outside the sensor
+
+    @note Used by luminox_get_derived_O2() when the sensor has no barometric pressure sensor
+
+    @param[in] pressure Barometric pressure in mbar, 0 or less to clear it
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+void luminox_set_external_pressure(float pressure, luminox_handler_t * luminox_handler) {
+    luminox_handler->external_pressure = (pressure > 0) ? pressure : 0;
+    luminox_handler->derived_sequence = luminox_handler->sample.sequence - 1; // invalidate the cached value
+}
+
+/*
+    @brief Function for getting the O2 percentage computed from ppO2 and barometric pressure
+
+    @note Uses the sensor's barometric pressure when it reports one, otherwise the pressure given to
+	  luminox_set_external_pressure(). Computed at most once per decoded response and cached.
+
+    @note Fails rather than reporting 0 % until a ppO2 value has been decoded, and while the newest response
+	  reported ppO2 as unavailable.
+
+    @param[out] o2 O2 in percent %, only written on success
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return luminox_retcode_t Either success, LUMINOX_ERR_NO_DATA without a ppO2 value
+			      or LUMINOX_ERR_NO_PRESSURE if no pressure is available
+*/
+luminox_retcode_t luminox_get_derived_O2(float * o2, luminox_handler_t * luminox_handler) {
+    if(!(luminox_handler->fields_seen & LUMINOX_FIELD_PPO2) || (luminox_handler->sample.missing & LUMINOX_FIELD_PPO2)) {
+        return LUMINOX_ERR_NO_DATA;
+    }
+    if(luminox_handler->derived_sequence != luminox_handler->sample.sequence) {
+        float pressure = luminox_handler->barometric_pressure_valid ? luminox_handler->sample.barometric_pressure : luminox_handler->external_pressure;
+        luminox_handler->derived_valid = (pressure > 0);
+        if(luminox_handler->derived_valid) {
+            luminox_handler->derived_O2 = luminox_handler->sample.ppo2 / pressure * 100.0f;
+        }
+        luminox_handler->derived_sequence = luminox_handler->sample.sequence;
+    }
+    if(!luminox_handler->derived_valid) {
+        return LUMINOX_ERR_NO_PRESSURE;
+    }
+    *o2 = luminox_handler->derived_O2;
+    return LUMINOX_SUCCESS;
 }
 
 /*
@@ -212,15 +493,29 @@ float luminox_get_barometric_pressure(luminox_handler_t * luminox_handler) {
     @return luminox_retcode_t Either success or one of the error codes
 */
 luminox_retcode_t luminox_request_sensor_status(luminox_handler_t * luminox_handler) {
+    LUMINOX_PROFILE_ENTER();
     unsigned char req[] = "e\r\n";
-    luminox_handler->luminox_tx(req, 3); // transmit the request
+    luminox_transmit(req, 3, luminox_handler); // transmit the request
 
      //luminox_wait_for_response(luminox_handler);
      luminox_process_response(luminox_handler);
 
+    LUMINOX_PROFILE_EXIT(LUMINOX_PROFILE_REQUEST_SENSOR_STATUS);
     return luminox_handler->err_code;
 }
 
+/*
+    @brief Function for getting the current sensor status
+
+    @note This function returns whatever is stored in the sample.status variable, which may be out of date. Call luminox_request_sensor_status() first.
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return Sensor status, 0 means the sensor status is good
+*/
+uint16_t luminox_get_sensor_status(luminox_handler_t * luminox_handler) {
+    return luminox_handler->sample.status;
+}
 
 /*
     @brief Function for requesting ppO2, O2, temperature, barometric pressure, and sensor status
@@ -232,16 +527,45 @@ luminox_retcode_t luminox_request_sensor_status(luminox_handler_t * luminox_hand
     @return luminox_retcode_t Either success or one of the error codes
 */
 luminox_retcode_t luminox_request_all(luminox_handler_t * luminox_handler) {
+    LUMINOX_PROFILE_ENTER();
     unsigned char req[] = "A\r\n";
-    luminox_handler->luminox_tx(req, 3); // transmit the request
+    luminox_transmit(req, 3, luminox_handler); // transmit the request
 
      //luminox_wait_for_response(luminox_handler);
      luminox_process_response(luminox_handler);
 
 
+    LUMINOX_PROFILE_EXIT(LUMINOX_PROFILE_REQUEST_ALL);
     return luminox_handler->err_code;
 }
 
+/*
+    @brief Function for sending one of the measurement requests
+
+    @param[in] command Measurement to request
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return luminox_retcode_t Either success, one of the error codes or LUMINOX_ERROR for an invalid command
+*/
+luminox_retcode_t luminox_request(luminox_command_t command, luminox_handler_t * luminox_handler) {
+    switch(command) {
+        case LUMINOX_COMMAND_ALL:
+            return luminox_request_all(luminox_handler);
+        case LUMINOX_COMMAND_PPO2:
+            return luminox_request_ppO2(luminox_handler);
+        case LUMINOX_COMMAND_O2:
+            return luminox_request_O2(luminox_handler);
+        case LUMINOX_COMMAND_TEMP:
+            return luminox_request_temp(luminox_handler);
+        case LUMINOX_COMMAND_BAROMETRIC_PRESSURE:
+            return luminox_request_barometric_pressure(luminox_handler);
+        case LUMINOX_COMMAND_SENSOR_STATUS:
+            return luminox_request_sensor_status(luminox_handler);
+    }
+    return LUMINOX_ERROR;
+}
+
 /*
     @brief Function for requesting the given sensor information
 
@@ -256,6 +580,7 @@ luminox_retcode_t luminox_request_all(luminox_handler_t * luminox_handler) {
     @return luminox_retcode_t Either success or one of the error codes
 */
 luminox_retcode_t luminox_request_sensor_info(luminox_sensor_info_t info, luminox_handler_t * luminox_handler) {
+    LUMINOX_PROFILE_ENTER();
     unsigned char info_req[] = "# x\r\n";
     // set command to given info
     switch(info) {
@@ -285,186 +610,1942 @@ luminox_retcode_t luminox_request_sensor_info(luminox_sensor_info_t info, lumino
 	    NRF_LOG_INFO("Invalid Info");
 	    NRF_LOG_FLUSH();
 #endif
+	    LUMINOX_PROFILE_EXIT(LUMINOX_PROFILE_REQUEST_SENSOR_INFO);
 	    return LUMINOX_ERR_INVALID_INFO;
     }
 
-    luminox_handler->luminox_tx(info_req, 5); // transmit the request
+    luminox_handler->pending_info = info; // the response doesn't say which information it holds
+    luminox_transmit(info_req, 5, luminox_handler); // transmit the request
 
      //luminox_wait_for_response(luminox_handler);
      luminox_process_response(luminox_handler);
 
+    LUMINOX_PROFILE_EXIT(LUMINOX_PROFILE_REQUEST_SENSOR_INFO);
     return luminox_handler->err_code;
 }
 
 /*
-    @brief Function for handling any unsuccessfull requests
-
-    @note Called in luminox_process_response if an error message is received from the sensor, 
-	  uses what's in luminox_data[] to process the error
+    @brief Function for getting the command character of a sequence step
 
-    @param[in] luminox_handler Pointer of library handler
+    @param[in] step Sequence step
 
-    @return luminox_retcode_t returns one of the defined luminox error codes
+    @return First character of the request, which the response starts with too
 */
-luminox_retcode_t luminox_error_handler(luminox_handler_t * luminox_handler) {
-    switch(luminox_handler->luminox_data[3]) {
-	    case 0x30:
-#ifdef DEBUG_OUTPUT
-	        NRF_LOG_INFO("Error: USART Receiver Overflow");
-		NRF_LOG_FLUSH();
-#endif
-	        return LUMINOX_ERR_RX_OVERFLOW;
-	    case 0x31:
-#ifdef DEBUG_OUTPUT
-	        NRF_LOG_INFO("Error: Invalid Command");
-		NRF_LOG_FLUSH();
-#endif
-	        return LUMINOX_ERR_INVALID_CMD;
-	    case 0x32:
-#ifdef DEBUG_OUTPUT
-	        NRF_LOG_INFO("Error: Invalid Frame");
-		NRF_LOG_FLUSH();
-#endif
-	        return LUMINOX_ERR_INVALID_FRAME;
-	    case 0x33:
-#ifdef DEBUG_OUTPUT
-	        NRF_LOG_INFO("Error: Invalid Argument");
-		NRF_LOG_FLUSH();
-#endif
-	        return LUMINOX_ERR_INVALID_ARG;
+static uint8_t luminox_step_command(luminox_step_t step) {
+    switch(step) {
+        case LUMINOX_STEP_MODE_POLLING:
+        case LUMINOX_STEP_MODE_DEFAULT:
+            return MODE_OUTPUT;
+        case LUMINOX_STEP_DATE_OF_MFG:
+        case LUMINOX_STEP_SERIAL_NUM:
+        case LUMINOX_STEP_SW_VER:
+            return SENSOR_INFORMATION;
+        case LUMINOX_STEP_SENSOR_STATUS:
+            return SENSOR_STATUS;
+        case LUMINOX_STEP_BAROMETRIC_PRESSURE:
+            return BAROMETRIC_PRESSURE;
+        default:
+            return ALL;
     }
-    return LUMINOX_ERROR;
 }
 
 /*
-    @brief Function for printing the response from the luminox sensor
-
-    @note The LuminOx sensor responds in ASCII encoded messages
+    @brief Function for transmitting the request of a sequence step without waiting for its response
 
-    @note Updates the current_x variables and err_code
+    @param[in] step Sequence step
 
     @param[in] luminox_handler Pointer of library handler
 */
-void luminox_process_response(luminox_handler_t * luminox_handler) {
-    uint16_t i = 0;
-    while(luminox_handler->luminox_data[i] != '\n') {
-        switch(luminox_handler->luminox_data[i]) {
-	        case ERROR_RESPONSE:
-		        luminox_handler->err_code = luminox_error_handler(luminox_handler);
-		        goto EndWhile; // break out of while loop (to stop printing rest of message)
-            case MODE_OUTPUT:
-                switch(luminox_handler->luminox_data[i+3]) {
-                    case 0x30:
-                        luminox_handler->current_mode = LUMINOX_MODE_STREAMING; // update current mode
-#ifdef DEBUG_OUTPUT
-        		        NRF_LOG_INFO("Mode changed to streaming mode.");
-				NRF_LOG_FLUSH();
-#endif
-        		        break;
-        	        case 0x31:
-			            luminox_handler->current_mode = LUMINOX_MODE_POLLING; // update current mode
-#ifdef DEBUG_OUTPUT
-        		        NRF_LOG_INFO("Mode changed to polling mode.");
-				NRF_LOG_FLUSH();
-#endif
-        		        break;
-        	        case 0x32:
-			            luminox_handler->current_mode = LUMINOX_MODE_OFF; // update current mode
-#ifdef DEBUG_OUTPUT
-        		        NRF_LOG_INFO("Mode changed to off.");
-				NRF_LOG_FLUSH();
-#endif
-        		        break;
-        	    }
-        	    goto EndWhile; // break out of while loop (to stop printing rest of message)
-            case PPO2: {
-                uint8_t ppo2_data[6];
-                i += 2; // increment by  2 to move the index to the start of the actual ppO2 data
-                memcpy(ppo2_data, &luminox_handler->luminox_data[i], sizeof(luminox_handler->luminox_data[i]) * 6); // separate ascii string with data from rest of response
-                float ppo2_flt = atof((char*)(ppo2_data)); // turn ascii response into floating point integer that the computer can use
-                luminox_handler->current_ppO2 = ppo2_flt; // update value
-#ifdef DEBUG_OUTPUT
-                NRF_LOG_INFO("ppO2 Value: " NRF_LOG_FLOAT_MARKER " mbar", ppo2_flt);
-		NRF_LOG_FLUSH();
-#endif
-		i += 5; // increment by 5 to move the index to the end of the string or next value in the response
-		break;
-            }
-            case O2: {
-		uint8_t o2_data[6];
-		i += 2;
-		memcpy(o2_data, &luminox_handler->luminox_data[i], sizeof(luminox_handler->luminox_data[i]) * 6);
-		float o2_flt = atof((char*)(o2_data));
-		luminox_handler->current_O2 = o2_flt;
-#ifdef DEBUG_OUTPUT
-                NRF_LOG_INFO("o2 Value: " NRF_LOG_FLOAT_MARKER " %", o2_flt);
-		NRF_LOG_FLUSH();
-#endif
-		i += 5;
-		break;
-            }
-            case TEMPERATURE: {
-                uint8_t temp_data[5];
-                i += 2;
-                memcpy(temp_data, &luminox_handler->luminox_data[i], sizeof(luminox_handler->luminox_data[i]) * 5);
-                float temp_flt = atof((char*)(temp_data));
-                luminox_handler->current_temp = temp_flt;
-#ifdef DEBUG_OUTPUT
-                NRF_LOG_INFO("Temperature: " NRF_LOG_FLOAT_MARKER " C", temp_flt);
-		NRF_LOG_FLUSH();
-#endif  
-		i += 4;
-		break;
-            }
-            case BAROMETRIC_PRESSURE: {
-                uint8_t barometric_data[4];
-                i += 2;
-                memcpy(barometric_data, &luminox_handler->luminox_data[i], sizeof(luminox_handler->luminox_data[i]) * 4);
-                float barometric_flt = atof((char*)(barometric_data));
-                luminox_handler->current_barometric_pressure = barometric_flt;
-#ifdef DEBUG_OUTPUT
-                NRF_LOG_INFO("Barometric Pressure: " NRF_LOG_FLOAT_MARKER " mbar", barometric_flt);
-		NRF_LOG_FLUSH();
-#endif
-                i += 3;
-                break;
-            }
-            case SEPARATOR:
-#ifdef DEBUG_OUTPUT
-		NRF_LOG_INFO(" ");
-		NRF_LOG_FLUSH();
-#endif
-		break;
-            case SENSOR_STATUS:
-#ifdef DEBUG_OUTPUT
-		NRF_LOG_INFO("Sensor Status:");
-		NRF_LOG_FLUSH();
-#endif
-		break;
-	    case SENSOR_INFORMATION:
-		break;
-            default:
-#ifdef DEBUG_OUTPUT
-	    NRF_LOG_INFO("%c", luminox_handler->luminox_data[i]);
-	    NRF_LOG_FLUSH();
-#endif
-	    break;
-        }
-
-        i++;
+static void luminox_send_step(luminox_step_t step, luminox_handler_t * luminox_handler) {
+    unsigned char req[] = "x x\r\n";
+    uint8_t size = 5;
+    req[0] = luminox_step_command(step);
+    switch(step) {
+        case LUMINOX_STEP_MODE_POLLING:
+            req[2] = '0' + LUMINOX_MODE_POLLING;
+            break;
+        case LUMINOX_STEP_MODE_DEFAULT:
+            req[2] = '0' + LUMINOX_MODE_DEFAULT;
+            break;
+        case LUMINOX_STEP_DATE_OF_MFG:
+        case LUMINOX_STEP_SERIAL_NUM:
+        case LUMINOX_STEP_SW_VER:
+            luminox_handler->pending_info = (luminox_sensor_info_t)(step - LUMINOX_STEP_DATE_OF_MFG);
+            req[2] = '0' + (step - LUMINOX_STEP_DATE_OF_MFG);
+            break;
+        default:
+            // measurement requests have no argument
+            req[1] = '\r';
+            req[2] = '\n';
+            size = 3;
+            break;
     }
-    EndWhile: ;
-#ifdef DEBUG_OUTPUT
-    NRF_LOG_INFO("");
-#endif
-    luminox_handler->err_code = LUMINOX_SUCCESS;
+    luminox_transmit(req, size, luminox_handler);
 }
 
+static void luminox_init_finish(luminox_handler_t * luminox_handler);
+
+// the requests of luminox_init(), for luminox_init_start()
+static const luminox_step_t luminox_init_sequence[] = {
+    LUMINOX_STEP_MODE_POLLING,
+    LUMINOX_STEP_DATE_OF_MFG,
+    LUMINOX_STEP_SERIAL_NUM,
+    LUMINOX_STEP_SW_VER,
+#ifndef LUMINOX_NO_BAROMETRIC
+    LUMINOX_STEP_BAROMETRIC_PRESSURE, // detects the variant
+#endif
+    LUMINOX_STEP_MODE_DEFAULT,
+    LUMINOX_STEP_END
+};
+
 /*
-    @brief Function for initializing communication with the LuminOx sensor
+    @brief Function for ending the running request sequence
 
-    @note First sets the output mode to polling to request and print out sensor information, then sets the output mode
-	  to default mode, which is set to be off. Then resets all of the static variables keeping track of state and recent sensor readings.
+    @param[in] result Outcome of the sequence
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+static void luminox_sequence_finish(luminox_retcode_t result, luminox_handler_t * luminox_handler) {
+    if(result == LUMINOX_SUCCESS && luminox_handler->sequence == luminox_init_sequence) {
+        luminox_init_finish(luminox_handler);
+    }
+    luminox_handler->sequence = NULL;
+    luminox_handler->sequence_result = result;
+}
+
+/*
+    @brief Function for starting a request sequence
+
+    @param[in] sequence Steps to run, terminated by LUMINOX_STEP_END
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return luminox_retcode_t Either success or LUMINOX_ERROR if a sequence is already running
+*/
+static luminox_retcode_t luminox_sequence_start(const luminox_step_t * sequence, luminox_handler_t * luminox_handler) {
+    if(luminox_handler->sequence != NULL) {
+        return LUMINOX_ERROR;
+    }
+    luminox_handler->sequence = sequence;
+    luminox_handler->sequence_step = 0;
+    luminox_handler->sequence_result = LUMINOX_ERROR;
+    luminox_send_step(sequence[0], luminox_handler);
+    return LUMINOX_SUCCESS;
+}
+
+/*
+    @brief Function for moving the running request sequence on after a response was processed
+
+    @note Responses that don't start with the command of the current step (e.g. a streamed measurement)
+	  are ignored, an error response ends the sequence
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+static void luminox_sequence_advance(luminox_handler_t * luminox_handler) {
+    luminox_step_t step = luminox_handler->sequence[luminox_handler->sequence_step];
+    uint8_t first = (luminox_handler->luminox_data_size > 0) ? luminox_handler->luminox_data[0] : 0;
+    uint8_t expected = (step == LUMINOX_STEP_ALL) ? PPO2 : luminox_step_command(step); // "A" is answered by "O ..."
+
+    if(first == ERROR_RESPONSE || (first == expected && luminox_handler->err_code != LUMINOX_SUCCESS)) {
+        luminox_sequence_finish(luminox_handler->err_code, luminox_handler);
+        return;
+    }
+    if(first != expected) {
+        return; // not the response to this step, keep waiting
+    }
+
+    step = luminox_handler->sequence[++luminox_handler->sequence_step];
+    if(step == LUMINOX_STEP_END) {
+        luminox_sequence_finish(LUMINOX_SUCCESS, luminox_handler);
+        return;
+    }
+    luminox_send_step(step, luminox_handler);
+}
+
+// polling mode first so a streaming sensor stops talking over the replies
+static const luminox_step_t luminox_probe_sequence[] = {
+    LUMINOX_STEP_MODE_POLLING,
+    LUMINOX_STEP_SERIAL_NUM,
+    LUMINOX_STEP_SENSOR_STATUS,
+    LUMINOX_STEP_ALL,
+    LUMINOX_STEP_END
+};
+
+/*
+    @brief Function for starting a non-blocking probe of the device on the UART
+
+    @note Sends the polling mode request, then the serial number, status and all measurements requests one at a time,
+	  each after luminox_process_response() handled the response of the one before. Feed the received bytes with
+	  luminox_receive_byte() and call luminox_process_response() for every complete response as usual, so many
+	  ports can be probed at once from one loop. Responses that don't answer the current request are ignored.
+
+    @note luminox_tx must not block. It is called from inside luminox_process_response() for every request after the
+	  first, so a luminox_tx that waits for the response (like the blocking uart_write() in the README) stalls
+	  the loop and probes the ports one after another. Copy the request, which is only valid during the call,
+	  into the port's TX buffer, start the transfer and return, e.g.
+	      void uart_write_async(unsigned char * tx, uint8_t size) {
+	          memcpy(port_tx_buf, tx, size);
+	          uart_tx_start(port_tx_buf, size); // interrupt or DMA driven, returns at once
+	      }
+
+    @note The device is a LuminOx sensor if luminox_sequence_result() is LUMINOX_SUCCESS once luminox_sequence_busy()
+	  returns false, the identity, status and measurements are then in the handler.
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return luminox_retcode_t Either success or LUMINOX_ERROR if a sequence is already running
+*/
+luminox_retcode_t luminox_probe_start(luminox_handler_t * luminox_handler) {
+    if(luminox_handler->sequence != NULL) {
+        return LUMINOX_ERROR;
+    }
+    memset(&luminox_handler->identity, 0, sizeof(luminox_identity_t));
+    return luminox_sequence_start(luminox_probe_sequence, luminox_handler);
+}
+
+/*
+    @brief Function for checking whether a non-blocking request sequence is still running
+
+    @note Also ends the sequence with LUMINOX_ERR_TIMEOUT when a response takes longer than LUMINOX_SEQUENCE_TIMEOUT_MS,
+	  call it from the loop that feeds the responses
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return true while the sequence waits for a response
+*/
+bool luminox_sequence_busy(luminox_handler_t * luminox_handler) {
+    if(luminox_handler->sequence == NULL) {
+        return false;
+    }
+    if(luminox_now(luminox_handler) - luminox_handler->request_time > LUMINOX_SEQUENCE_TIMEOUT_MS) {
+#ifdef DEBUG_OUTPUT
+        NRF_LOG_INFO("Request sequence timeout");
+        NRF_LOG_FLUSH();
+#endif
+        luminox_handler->request_pending = false;
+        luminox_sequence_finish(LUMINOX_ERR_TIMEOUT, luminox_handler);
+        return false;
+    }
+    return true;
+}
+
+/*
+    @brief Function for getting the outcome of the last non-blocking request sequence
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return luminox_retcode_t Success, the error of the request that failed, LUMINOX_ERR_TIMEOUT,
+			      or LUMINOX_ERROR while the sequence is running
+*/
+luminox_retcode_t luminox_sequence_result(luminox_handler_t * luminox_handler) {
+    return luminox_handler->sequence_result;
+}
+
+/*
+    @brief Function for getting the time between the last request and its response
+
+    @note Requires luminox_get_time to be initialized, otherwise always 0
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return Latency of the last request in milliseconds
+*/
+uint32_t luminox_get_response_latency(luminox_handler_t * luminox_handler) {
+    return luminox_handler->response_latency;
+}
+
+/*
+    @brief Function for getting the UART traffic and utilisation of the sensor
+
+    @note Utilisation is the share of the window the line spent transferring bytes at LUMINOX_BAUDRATE.
+	  TX and RX are reported separately because the UART is full duplex.
+
+    @param[out] stats Filled in with the totals and the figures for the sliding window
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return luminox_retcode_t Either success or LUMINOX_ERROR if there is no time source
+*/
+luminox_retcode_t luminox_get_bus_stats(luminox_bus_stats_t * stats, luminox_handler_t * luminox_handler) {
+    if(luminox_handler->luminox_get_time == NULL && !luminox_handler->replay_active) {
+        return LUMINOX_ERROR;
+    }
+    luminox_bus_slot(luminox_handler); // drop slots that fell out of the window
+
+    stats->tx_bytes_total = luminox_handler->tx_bytes_total;
+    stats->rx_bytes_total = luminox_handler->rx_bytes_total;
+    stats->tx_bytes = 0;
+    stats->rx_bytes = 0;
+    for(uint8_t i = 0; i < LUMINOX_BUS_WINDOW_SLOTS; i++) {
+        stats->tx_bytes += luminox_handler->bus_slots[i].tx_bytes;
+        stats->rx_bytes += luminox_handler->bus_slots[i].rx_bytes;
+    }
+
+    // full slots before the current one plus the part of the current slot that has passed
+    stats->window_ms = luminox_handler->bus_slots_used * LUMINOX_BUS_SLOT_MS + luminox_now(luminox_handler) % LUMINOX_BUS_SLOT_MS;
+    if(stats->window_ms == 0) {
+        stats->window_ms = 1;
+    }
+
+    const uint32_t bytes_per_second = LUMINOX_BAUDRATE / LUMINOX_BITS_PER_BYTE;
+    float capacity = (float)bytes_per_second * stats->window_ms / 1000.0f; // bytes the line could carry during the window
+    stats->tx_utilisation = 100.0f * stats->tx_bytes / capacity;
+    stats->rx_utilisation = 100.0f * stats->rx_bytes / capacity;
+
+    uint32_t busiest = (stats->tx_bytes > stats->rx_bytes) ? stats->tx_bytes : stats->rx_bytes;
+    uint32_t used_per_second = (uint32_t)((uint64_t)busiest * 1000 / stats->window_ms);
+    stats->headroom = (used_per_second < bytes_per_second) ? bytes_per_second - used_per_second : 0;
+
+    return LUMINOX_SUCCESS;
+}
+
+/*
+    @brief Function for replaying captured UART transfers through the driver
+
+    @note Time is taken from the record timestamps instead of luminox_get_time, so a capture replays as fast
+	  as the micro can decode it. RX records are decoded with luminox_process_response() exactly as
+	  they were live, TX records only advance the clock and start the latency measurement.
+	  The capture callback is not called while replaying.
+
+    @param[in] records Array of records, as recorded by the luminox_capture callback
+
+    @param[in] count Number of records in the array
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return luminox_retcode_t Success, or the first error code returned while decoding a response
+*/
+luminox_retcode_t luminox_replay(const luminox_capture_record_t * records, uint32_t count, luminox_handler_t * luminox_handler) {
+    luminox_retcode_t ret = LUMINOX_SUCCESS;
+    luminox_handler->replay_active = true;
+
+    for(uint32_t i = 0; i < count; i++) {
+        luminox_handler->virtual_time = records[i].timestamp;
+        if(records[i].direction == LUMINOX_CAPTURE_TX) {
+            luminox_handler->request_time = records[i].timestamp;
+            luminox_handler->request_pending = true;
+            continue;
+        }
+        luminox_update_data((uint8_t *)records[i].data, records[i].size, luminox_handler);
+        luminox_process_response(luminox_handler);
+        if(ret == LUMINOX_SUCCESS && luminox_handler->err_code != LUMINOX_SUCCESS) {
+            ret = luminox_handler->err_code;
+        }
+    }
+
+    luminox_handler->replay_active = false;
+    return ret;
+}
+
+#ifdef LUMINOX_PROFILING
+/*
+    @brief Function for getting the profile of a driver entry point
+
+    @param[in] id Entry point to get the profile of
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return Pointer to the min/max/total cycles and call count of the entry point, NULL for an invalid id
+*/
+const luminox_profile_stat_t * luminox_get_profile(luminox_profile_id_t id, luminox_handler_t * luminox_handler) {
+    if(id >= LUMINOX_PROFILE_COUNT) {
+        return NULL;
+    }
+    return &luminox_handler->profile[id];
+}
+
+/*
+    @brief Function for clearing the profiles of every driver entry point
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+void luminox_reset_profile(luminox_handler_t * luminox_handler) {
+    memset(luminox_handler->profile, 0, sizeof(luminox_handler->profile));
+}
+#endif
+
+/*
+    @brief Function for subscribing to decoded measurements
+
+    @note The callback is called from luminox_process_response() whenever a response updates one of the fields
+	  in field_mask, or holds one back as a possible step (see luminox_set_spike_filter()). Register subscribers after luminox_init(), which clears the subscriber table.
+
+    @param[in] callback Function to call with a pointer to the decoded sample
+
+    @param[in] context Pointer passed back to the callback
+
+    @param[in] field_mask luminox_field_t mask of the fields the subscriber is interested in
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return luminox_retcode_t Either success or LUMINOX_ERR_FULL if all LUMINOX_MAX_SUBSCRIBERS entries are used
+*/
+luminox_retcode_t luminox_subscribe(luminox_subscriber_cb_t callback, void * context, uint8_t field_mask, luminox_handler_t * luminox_handler) {
+    if(callback == NULL) {
+        return LUMINOX_ERROR;
+    }
+    if(luminox_handler->subscriber_count >= LUMINOX_MAX_SUBSCRIBERS) {
+#ifdef DEBUG_OUTPUT
+        NRF_LOG_INFO("Subscriber table full");
+        NRF_LOG_FLUSH();
+#endif
+        return LUMINOX_ERR_FULL;
+    }
+
+    luminox_subscriber_t * subscriber = &luminox_handler->subscribers[luminox_handler->subscriber_count++];
+    subscriber->callback = callback;
+    subscriber->context = context;
+    subscriber->field_mask = field_mask;
+
+    return LUMINOX_SUCCESS;
+}
+
+/*
+    @brief Function for removing a subscriber registered with luminox_subscribe()
+
+    @param[in] callback Callback of the subscriber to remove
+
+    @param[in] context Context of the subscriber to remove
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return luminox_retcode_t Either success or LUMINOX_ERROR if no matching subscriber was found
+*/
+luminox_retcode_t luminox_unsubscribe(luminox_subscriber_cb_t callback, void * context, luminox_handler_t * luminox_handler) {
+    for(uint8_t i = 0; i < luminox_handler->subscriber_count; i++) {
+        if(luminox_handler->subscribers[i].callback == callback && luminox_handler->subscribers[i].context == context) {
+            // move the last entry into the freed slot, order of the table does not matter
+            luminox_handler->subscribers[i] = luminox_handler->subscribers[--luminox_handler->subscriber_count];
+            return LUMINOX_SUCCESS;
+        }
+    }
+    return LUMINOX_ERROR;
+}
+
+/*
+    @brief Function for collecting decoded samples into a batch buffer
+
+    @note Every sample decoded by luminox_process_response() is copied into buffer. The callback is called once the
+	  buffer holds capacity samples, or deadline_ms after the first sample of the batch, whichever comes first.
+	  Call luminox_poll_batch() from the super loop so the deadline is also met when no new samples arrive.
+	  luminox_init() turns batching off.
+
+    @param[in] buffer Caller owned array of capacity samples, NULL to turn batching off
+
+    @param[in] capacity Number of samples in buffer
+
+    @param[in] deadline_ms Maximum age of the first sample in a batch before delivery, 0 to only deliver full batches
+
+    @param[in] callback Function to call with each batch
+
+    @param[in] context Pointer passed back to the callback
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return luminox_retcode_t Either success or LUMINOX_ERROR if buffer is set without a capacity or callback
+*/
+luminox_retcode_t luminox_set_batch(luminox_sample_t * buffer, uint16_t capacity, uint32_t deadline_ms, luminox_batch_cb_t callback, void * context, luminox_handler_t * luminox_handler) {
+    if(buffer != NULL && (capacity == 0 || callback == NULL)) {
+        return LUMINOX_ERROR;
+    }
+    luminox_handler->batch = buffer;
+    luminox_handler->batch_capacity = capacity;
+    luminox_handler->batch_count = 0;
+    luminox_handler->batch_deadline_ms = deadline_ms;
+    luminox_handler->batch_callback = callback;
+    luminox_handler->batch_context = context;
+    return LUMINOX_SUCCESS;
+}
+
+/*
+    @brief Function for delivering the samples in the batch buffer right away
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+void luminox_flush_batch(luminox_handler_t * luminox_handler) {
+    if(luminox_handler->batch == NULL || luminox_handler->batch_count == 0) {
+        return;
+    }
+    uint16_t count = luminox_handler->batch_count;
+    luminox_handler->batch_count = 0; // reset first so the callback may add samples
+    luminox_handler->batch_callback(luminox_handler->batch, count, luminox_handler->batch_context);
+}
+
+/*
+    @brief Function for delivering the batch if its deadline has passed
+
+    @note Call this function in your super loop when batching is used
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+void luminox_poll_batch(luminox_handler_t * luminox_handler) {
+    if(luminox_handler->batch_count > 0 && luminox_handler->batch_deadline_ms != 0
+        && luminox_now(luminox_handler) - luminox_handler->batch_start >= luminox_handler->batch_deadline_ms) {
+        luminox_flush_batch(luminox_handler);
+    }
+}
+
+/*
+    @brief Function for adding the decoded sample to the batch buffer
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+static void luminox_batch_sample(luminox_handler_t * luminox_handler) {
+    if(luminox_handler->batch == NULL) {
+        return;
+    }
+    if(luminox_handler->batch_count == 0) {
+        luminox_handler->batch_start = luminox_handler->sample.timestamp;
+    }
+    luminox_handler->batch[luminox_handler->batch_count++] = luminox_handler->sample;
+    if(luminox_handler->batch_count >= luminox_handler->batch_capacity) {
+        luminox_flush_batch(luminox_handler);
+    } else {
+        luminox_poll_batch(luminox_handler);
+    }
+}
+
+/*
+    @brief Function for configuring the deadband of a field
+
+    @note Every field starts with no deadband after luminox_init(), so any change is an exception.
+	  Subscribers registered with LUMINOX_FIELD_EXCEPTIONS_ONLY in their mask are only called when one of
+	  their fields is in the sample's exceptions mask.
+
+    @param[in] field Single luminox_field_t to configure
+
+    @param[in] absolute Change in the unit of the field that is reported
+
+    @param[in] relative Change as a fraction of the last reported value that is reported
+
+    @param[in] max_silence_ms Report the field at least this often even if it doesn't change, 0 to disable
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return luminox_retcode_t Either success or LUMINOX_ERROR if field is not a single field
+*/
+luminox_retcode_t luminox_set_deadband(luminox_field_t field, float absolute, float relative, uint32_t max_silence_ms, luminox_handler_t * luminox_handler) {
+    for(uint8_t i = 0; i < LUMINOX_FIELD_COUNT; i++) {
+        if((uint8_t)field == (1 << i)) {
+            luminox_deadband_t * deadband = &luminox_handler->deadband[i];
+            deadband->absolute = absolute;
+            deadband->relative = relative;
+            deadband->max_silence_ms = max_silence_ms;
+            return LUMINOX_SUCCESS;
+        }
+    }
+    return LUMINOX_ERROR;
+}
+
+/*
+    @brief Function for getting a field of a sample by its bit number
+
+    @param[in] sample Sample to read
+
+    @param[in] index Bit number of the luminox_field_t
+
+    @return Value of the field, the status is converted to float
+*/
+static float luminox_sample_field(const luminox_sample_t * sample, uint8_t index) {
+    switch(index) {
+        case 0:
+            return sample->ppo2;
+        case 1:
+            return sample->o2;
+        case 2:
+            return sample->temp;
+        case 3:
+            return sample->barometric_pressure;
+        default:
+            return sample->status;
+    }
+}
+
+/*
+    @brief Function for setting a field of a sample by its bit number
+
+    @param[in] sample Sample to update
+
+    @param[in] index Bit number of one of the float fields
+
+    @param[in] value New value of the field
+*/
+static void luminox_set_sample_field(luminox_sample_t * sample, uint8_t index, float value) {
+    switch(index) {
+        case 0:
+            sample->ppo2 = value;
+            break;
+        case 1:
+            sample->o2 = value;
+            break;
+        case 2:
+            sample->temp = value;
+            break;
+        default:
+            sample->barometric_pressure = value;
+            break;
+    }
+}
+
+/*
+    @brief Function for getting the bit number of a single float field
+
+    @param[in] field Single luminox_field_t
+
+    @return Bit number of the field, LUMINOX_FLOAT_FIELD_COUNT if it isn't a single float field
+*/
+static uint8_t luminox_float_field_index(luminox_field_t field) {
+    for(uint8_t i = 0; i < LUMINOX_FLOAT_FIELD_COUNT; i++) {
+        if((uint8_t)field == (1 << i)) {
+            return i;
+        }
+    }
+    return LUMINOX_FLOAT_FIELD_COUNT;
+}
+
+/*
+    @brief Function for getting the uncompensated value of a field, see luminox_compensate()
+
+    @param[in] sample Sample holding the value
+
+    @param[in] index Bit number of the field
+
+    @return Pointer to sample.ppo2_raw or sample.o2_raw, NULL for fields without an uncompensated value
+*/
+static float * luminox_sample_raw(luminox_sample_t * sample, uint8_t index) {
+    switch(index) {
+        case 0:
+            return &sample->ppo2_raw;
+        case 1:
+            return &sample->o2_raw;
+        default:
+            return NULL;
+    }
+}
+
+/*
+    @brief Function for holding back spikes and flagging steps in the values of the last response
+
+    @note Constant work per value, see luminox_spike_filter_t for the classification
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+static void luminox_filter_spikes(luminox_handler_t * luminox_handler) {
+    luminox_sample_t * sample = &luminox_handler->sample;
+    sample->suppressed = 0;
+    sample->steps = 0;
+    sample->possible_steps = 0;
+    for(uint8_t i = 0; i < LUMINOX_FLOAT_FIELD_COUNT; i++) {
+        luminox_spike_filter_t * filter = &luminox_handler->spike_filter[i];
+        if(filter->threshold == 0 || !(sample->fields & (1 << i))) {
+            continue;
+        }
+        float value = luminox_sample_field(sample, i);
+        float * raw = luminox_sample_raw(sample, i);
+        if(!filter->accepted || fabsf(value - filter->reference) <= filter->threshold) {
+            if(filter->held > 0) {
+                filter->spikes++; // came back before the window passed
+                filter->held = 0;
+            }
+            filter->reference = value;
+            filter->reference_raw = (raw != NULL) ? *raw : value;
+            filter->accepted = true;
+            continue;
+        }
+
+        // away from the accepted level, count values in a row at the same new level
+        if(filter->held == 0 || fabsf(value - filter->candidate) > filter->threshold) {
+            if(filter->held > 0) {
+                filter->spikes++; // the earlier held values didn't settle either
+            }
+            filter->candidate = value;
+            filter->held = 0;
+        }
+        filter->held++;
+        if(filter->held >= filter->window) {
+            filter->steps++;
+            filter->held = 0;
+            filter->reference = value;
+            filter->reference_raw = (raw != NULL) ? *raw : value;
+            sample->steps |= (1 << i);
+        } else {
+            sample->fields &= ~(1 << i);
+            sample->suppressed |= (1 << i);
+            luminox_set_sample_field(sample, i, filter->reference);
+            if(raw != NULL) {
+                *raw = filter->reference_raw; // the uncompensated value is held back too
+            }
+            if(filter->held == 1) {
+                sample->possible_steps |= (1 << i); // first value of a new level, subscribers hear of it at once
+            }
+        }
+    }
+}
+
+/*
+    @brief Function for configuring the spike and step detector of a field
+
+    @note Runs on every decoded value before the deadband, history and subscribers, so a dropped spike never
+	  reaches them. A held back value is left out of the sample's fields and set in its suppressed mask, and the
+	  getters, sample.ppo2_raw and sample.o2_raw keep the last accepted value. The first value at a new level
+	  sets the field's bit in the sample's possible_steps mask and calls the field's subscribers, even though
+	  the value itself is held back, they find it in the candidate of luminox_get_spike_filter(). A step is confirmed in the steps mask window - 1 responses later, a spike
+	  never is.
+
+    @param[in] field Single float field: ppO2, O2, temperature or barometric pressure
+
+    @param[in] threshold Jump in the unit of the field that is held back, 0 to turn the detector off
+
+    @param[in] window Values in a row at a new level that confirm a step, at least 1
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return luminox_retcode_t Either success or LUMINOX_ERR_INVALID_ARG for an invalid field, threshold or window
+*/
+luminox_retcode_t luminox_set_spike_filter(luminox_field_t field, float threshold, uint8_t window, luminox_handler_t * luminox_handler) {
+    uint8_t index = luminox_float_field_index(field);
+    if(index >= LUMINOX_FLOAT_FIELD_COUNT || !(threshold >= 0) || window < 1) {
+        return LUMINOX_ERR_INVALID_ARG;
+    }
+    luminox_spike_filter_t * filter = &luminox_handler->spike_filter[index];
+    filter->threshold = threshold;
+    filter->window = window;
+    filter->held = 0;
+    return LUMINOX_SUCCESS;
+}
+
+/*
+    @brief Function for getting the state and counters of the spike and step detector of a field
+
+    @param[in] field Single float field: ppO2, O2, temperature or barometric pressure
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return Pointer to the detector, NULL for an invalid field
+*/
+const luminox_spike_filter_t * luminox_get_spike_filter(luminox_field_t field, luminox_handler_t * luminox_handler) {
+    uint8_t index = luminox_float_field_index(field);
+    if(index >= LUMINOX_FLOAT_FIELD_COUNT) {
+        return NULL;
+    }
+    return &luminox_handler->spike_filter[index];
+}
+
+/*
+    @brief Function for finding the histogram of a tracked field
+
+    @param[in] field Single float field
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return Pointer to the histogram, NULL if the field isn't tracked
+*/
+static luminox_quantile_t * luminox_find_quantile(luminox_field_t field, luminox_handler_t * luminox_handler) {
+    for(uint8_t i = 0; i < luminox_handler->quantile_count; i++) {
+        luminox_quantile_t * quantile = &luminox_handler->quantiles[i];
+        if(quantile->field == (uint8_t)field) {
+            return quantile;
+        }
+    }
+    return NULL;
+}
+
+/*
+    @brief Function for starting to track the quantiles of a field
+
+    @note Every value decoded afterwards is counted in the field's histogram in constant memory. Once a field is
+	  tracked, any quantile of it can be read, not only p. The tracked fields are cleared by luminox_init(),
+	  so call it afterwards.
+
+    @param[in] field Single float field: ppO2, O2, temperature or barometric pressure
+
+    @param[in] p Quantile that will be read, e.g. 0.01 for p1 or 0.99 for p99
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return luminox_retcode_t Either success, LUMINOX_ERR_INVALID_ARG for an invalid field or p
+			      or LUMINOX_ERR_FULL if LUMINOX_MAX_QUANTILES other fields are tracked
+*/
+luminox_retcode_t luminox_track_quantile(luminox_field_t field, float p, luminox_handler_t * luminox_handler) {
+    if((field != LUMINOX_FIELD_PPO2 && field != LUMINOX_FIELD_O2 && field != LUMINOX_FIELD_TEMP && field != LUMINOX_FIELD_BAROMETRIC_PRESSURE)
+        || !(p > 0.0f && p < 1.0f)) {
+        return LUMINOX_ERR_INVALID_ARG;
+    }
+    if(luminox_find_quantile(field, luminox_handler) != NULL) {
+        return LUMINOX_SUCCESS; // already tracked, its histogram serves every p
+    }
+    if(luminox_handler->quantile_count >= LUMINOX_MAX_QUANTILES) {
+        return LUMINOX_ERR_FULL;
+    }
+    luminox_quantile_t * quantile = &luminox_handler->quantiles[luminox_handler->quantile_count++];
+    memset(quantile, 0, sizeof(luminox_quantile_t));
+    quantile->field = (uint8_t)field;
+    return LUMINOX_SUCCESS;
+}
+
+/*
+    @brief Function for getting the reading resolution of a float field
+
+    @param[in] index Bit number of the field
+
+    @return Smallest step the sensor reports the field in
+*/
+static float luminox_quantile_resolution(uint8_t index) {
+    switch(index) {
+        case 0:
+            return 0.1f; // ppO2, xxxx.x mbar
+        case 1:
+            return 0.01f; // O2, xxx.xx %
+        case 2:
+            return 0.1f; // temperature, yxx.x C
+        default:
+            return 1.0f; // barometric pressure, xxxx mbar
+    }
+}
+
+/*
+    @brief Function for dividing a reading step by a power of two, rounding towards minus infinity
+
+    @param[in] step Reading step, may be negative
+
+    @param[in] shift Power of two to divide by
+
+    @return Index of the bin of width 2^shift that holds the step
+*/
+static int32_t luminox_quantile_bin(int32_t step, uint8_t shift) {
+    return (step >= 0) ? (step >> shift) : -((-(step + 1)) >> shift) - 1;
+}
+
+/*
+    @brief Function for moving the bins of a histogram so a step falls inside them
+
+    @note Recentres the bins on the counted values and the step when they span fewer than LUMINOX_QUANTILE_BINS
+	  bins, and otherwise doubles the bin width first, merging neighbouring bins. Called again until the step fits.
+
+    @param[in] quantile Histogram to update, holding at least one value
+
+    @param[in] step Reading step of the value that doesn't fit
+*/
+static void luminox_quantile_widen(luminox_quantile_t * quantile, int32_t step) {
+    uint32_t bins[LUMINOX_QUANTILE_BINS];
+    int32_t low = 0;
+    int32_t high = 0;
+    bool found = false;
+    for(int32_t i = 0; i < LUMINOX_QUANTILE_BINS; i++) {
+        if(quantile->bins[i] != 0) {
+            high = i;
+            if(!found) {
+                low = i;
+                found = true;
+            }
+        }
+    }
+    low += quantile->first;
+    high += quantile->first;
+
+    // steps and counted values in bins of the new width
+    int32_t bin = luminox_quantile_bin(step, quantile->shift);
+    uint8_t shift = quantile->shift;
+    if(((bin < low) ? high - bin : bin - low) >= LUMINOX_QUANTILE_BINS) {
+        shift++;
+        bin = luminox_quantile_bin(step, shift);
+        low = luminox_quantile_bin(low, 1);
+        high = luminox_quantile_bin(high, 1);
+    }
+    if(((bin < low) ? high - bin : bin - low) < LUMINOX_QUANTILE_BINS) {
+        low = (bin < low) ? bin : low;
+        high = (bin > high) ? bin : high;
+    } // else the step needs another doubling, centre the values for now
+
+    int32_t first = low - (LUMINOX_QUANTILE_BINS - 1 - (high - low)) / 2;
+    memset(bins, 0, sizeof(bins));
+    for(int32_t i = 0; i < LUMINOX_QUANTILE_BINS; i++) {
+        if(quantile->bins[i] != 0) {
+            bins[luminox_quantile_bin(quantile->first + i, shift - quantile->shift) - first] += quantile->bins[i];
+        }
+    }
+    memcpy(quantile->bins, bins, sizeof(bins));
+    quantile->first = first;
+    quantile->shift = shift;
+}
+
+/*
+    @brief Function for adding a value to the histogram of its field
+
+    @note Constant time, except when the value lies outside the bins and luminox_quantile_widen() moves them
+
+    @param[in] quantile Histogram to update
+
+    @param[in] value Decoded value of the histogram's field
+
+    @param[in] resolution Reading resolution of the field
+*/
+static void luminox_quantile_add(luminox_quantile_t * quantile, float value, float resolution) {
+    float steps = value / resolution;
+    steps = (steps > 1e9f) ? 1e9f : (steps < -1e9f) ? -1e9f : steps; // keeps corrupt values inside int32_t
+    int32_t step = (int32_t)((steps >= 0) ? steps + 0.5f : steps - 0.5f); // nearest reading step
+
+    if(quantile->count == 0) {
+        memset(quantile->bins, 0, sizeof(quantile->bins));
+        quantile->shift = 0;
+        quantile->first = step - LUMINOX_QUANTILE_BINS / 2;
+    }
+    int32_t bin = luminox_quantile_bin(step, quantile->shift) - quantile->first;
+    while(bin < 0 || bin >= LUMINOX_QUANTILE_BINS) {
+        luminox_quantile_widen(quantile, step);
+        bin = luminox_quantile_bin(step, quantile->shift) - quantile->first;
+    }
+    quantile->bins[bin]++;
+    quantile->count++;
+}
+
+/*
+    @brief Function for adding the values of the last response to the histogram of every tracked field
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+static void luminox_quantiles_add(luminox_handler_t * luminox_handler) {
+    const luminox_sample_t * sample = &luminox_handler->sample;
+    for(uint8_t i = 0; i < luminox_handler->quantile_count; i++) {
+        luminox_quantile_t * quantile = &luminox_handler->quantiles[i];
+        if(sample->fields & quantile->field) {
+            uint8_t index = luminox_float_field_index((luminox_field_t)quantile->field);
+            luminox_quantile_add(quantile, luminox_sample_field(sample, index), luminox_quantile_resolution(index));
+        }
+    }
+}
+
+/*
+    @brief Function for getting a quantile of a tracked field
+
+    @note Returns the middle of the histogram bin holding the nearest rank quantile (the value at rank ceil(p * count))
+	  of the values since the last reset, rounded to the field's reading resolution. It is never further than
+	  half a bin width from that quantile. Bins are one reading step wide, so the result is exact, until the values
+	  span LUMINOX_QUANTILE_BINS reading steps. Wider spans double the bin width only as often as needed, so a bin
+	  stays narrower than 2 * span / (LUMINOX_QUANTILE_BINS - 1) reading steps. The width in use is 2^shift steps
+	  of the field's luminox_quantile_t. A single outlier counts towards the span until the next reset.
+	  tools/luminox_quantile_check.c checks both bounds.
+
+    @param[in] field Field passed to luminox_track_quantile()
+
+    @param[in] p Quantile, 0 < p < 1
+
+    @param[out] value Quantile of the values since the last reset
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return luminox_retcode_t Either success, LUMINOX_ERR_INVALID_ARG if the field isn't tracked or p is invalid
+			      or LUMINOX_ERROR if no value was seen yet
+*/
+luminox_retcode_t luminox_get_quantile(luminox_field_t field, float p, float * value, luminox_handler_t * luminox_handler) {
+    const luminox_quantile_t * quantile = luminox_find_quantile(field, luminox_handler);
+    if(quantile == NULL || !(p > 0.0f && p < 1.0f)) {
+        return LUMINOX_ERR_INVALID_ARG;
+    }
+    if(quantile->count == 0) {
+        return LUMINOX_ERROR;
+    }
+    double target = (double)p * quantile->count;
+    uint32_t rank = (uint32_t)target;
+    rank += (rank < target) ? 1 : 0; // ceil without libm
+    rank = (rank < 1) ? 1 : (rank > quantile->count) ? quantile->count : rank;
+    uint32_t seen = 0;
+    int32_t i = 0;
+    while(seen + quantile->bins[i] < rank) {
+        seen += quantile->bins[i++];
+    }
+    float width = (float)((uint32_t)1 << quantile->shift);
+    float start = (float)(quantile->first + i) * width; // first reading step of the bin
+    *value = (start + (width - 1) / 2) * luminox_quantile_resolution(luminox_float_field_index(field));
+    return LUMINOX_SUCCESS;
+}
+
+/*
+    @brief Function for emptying the histogram of every tracked field, e.g. at the start of a shift
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+void luminox_reset_quantiles(luminox_handler_t * luminox_handler) {
+    for(uint8_t i = 0; i < luminox_handler->quantile_count; i++) {
+        luminox_handler->quantiles[i].count = 0;
+    }
+}
+
+/*
+    @brief Function for finding the updated fields that moved past their deadband
+
+    @note Sets the sample's exceptions mask and remembers the reported values
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+static void luminox_apply_deadband(luminox_handler_t * luminox_handler) {
+    luminox_sample_t * sample = &luminox_handler->sample;
+    sample->exceptions = 0;
+    for(uint8_t i = 0; i < LUMINOX_FIELD_COUNT; i++) {
+        if(!(sample->fields & (1 << i))) {
+            continue;
+        }
+        luminox_deadband_t * deadband = &luminox_handler->deadband[i];
+        float value = luminox_sample_field(sample, i);
+        bool report = !deadband->reported;
+        if(!report) {
+            float change = value - deadband->last_value;
+            float last = deadband->last_value;
+            if(change < 0) {
+                change = -change;
+            }
+            if(last < 0) {
+                last = -last;
+            }
+            report = (change > deadband->absolute && change > deadband->relative * last)
+                || (deadband->max_silence_ms != 0 && sample->timestamp - deadband->last_time >= deadband->max_silence_ms);
+        }
+        if(report) {
+            sample->exceptions |= (1 << i);
+            deadband->last_value = value;
+            deadband->last_time = sample->timestamp;
+            deadband->reported = true;
+        }
+    }
+}
+
+/*
+    @brief Function for calling every subscriber interested in the fields updated by the last response,
+	   or held back by it as a possible step
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+static void luminox_notify_subscribers(luminox_handler_t * luminox_handler) {
+    const luminox_sample_t * sample = &luminox_handler->sample;
+    for(uint8_t i = 0; i < luminox_handler->subscriber_count; i++) {
+        const luminox_subscriber_t * subscriber = &luminox_handler->subscribers[i];
+        uint8_t fields = (subscriber->field_mask & LUMINOX_FIELD_EXCEPTIONS_ONLY) ? sample->exceptions : sample->fields;
+        if(subscriber->field_mask & (fields | sample->possible_steps)) {
+            subscriber->callback(sample, subscriber->context);
+        }
+    }
+}
+
+#ifdef LUMINOX_HISTORY
+/*
+    @brief Function for getting the history ring of decoded samples
+
+    @note The columns are updated in place by luminox_process_response(), read them between responses
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return Pointer to the history ring of the handler
+*/
+const luminox_history_t * luminox_get_history(luminox_handler_t * luminox_handler) {
+    return &luminox_handler->history;
+}
+
+/*
+    @brief Function for splitting the history ring into contiguous runs from oldest to newest
+
+    @note The first segment holds the oldest samples. The second segment is only used once the ring has
+	  wrapped, otherwise its count is 0. The same segments apply to every column.
+
+    @param[in] history History ring to split
+
+    @param[out] segments Two segments, oldest samples first
+*/
+void luminox_history_segments(const luminox_history_t * history, luminox_history_segment_t segments[2]) {
+    if(history->count < LUMINOX_HISTORY_SIZE) {
+        // not wrapped yet, samples run from 0 to head
+        segments[0].start = 0;
+        segments[0].count = history->count;
+        segments[1].start = 0;
+        segments[1].count = 0;
+    } else {
+        segments[0].start = history->head;
+        segments[0].count = LUMINOX_HISTORY_SIZE - history->head;
+        segments[1].start = 0;
+        segments[1].count = history->head;
+    }
+}
+#endif
+
+#ifdef LUMINOX_ROLLUPS
+// @brief layout of a rollup tier inside luminox_handler_t.rollup
+typedef struct {
+    uint16_t offset; // index of the tier's first bucket
+    uint16_t size; // number of buckets in the tier
+    uint32_t period_ms;
+} luminox_rollup_layout_t;
+
+static const luminox_rollup_layout_t luminox_rollup_layout[LUMINOX_ROLLUP_TIER_COUNT] = {
+    { 0, LUMINOX_ROLLUP_MINUTES, 60000UL },
+    { LUMINOX_ROLLUP_MINUTES, LUMINOX_ROLLUP_HOURS, 3600000UL }
+};
+
+/*
+    @brief Function for adding the values of the last response to the current bucket of every rollup tier
+
+    @note Starts a new bucket, overwriting the oldest, when the sample belongs to a later period than the current one
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+static void luminox_rollup_add(luminox_handler_t * luminox_handler) {
+    const luminox_sample_t * sample = &luminox_handler->sample;
+
+    for(uint8_t tier = 0; tier < LUMINOX_ROLLUP_TIER_COUNT; tier++) {
+        const luminox_rollup_layout_t * layout = &luminox_rollup_layout[tier];
+        uint32_t start = sample->timestamp - sample->timestamp % layout->period_ms;
+        uint16_t head = luminox_handler->rollup_head[tier];
+        luminox_rollup_bucket_t * bucket = &luminox_handler->rollup[layout->offset + head];
+
+        if(luminox_handler->rollup_count[tier] == 0 || bucket->start != start) {
+            if(luminox_handler->rollup_count[tier] != 0) {
+                head = (head + 1 < layout->size) ? head + 1 : 0;
+                luminox_handler->rollup_head[tier] = head;
+                bucket = &luminox_handler->rollup[layout->offset + head];
+            }
+            if(luminox_handler->rollup_count[tier] < layout->size) {
+                luminox_handler->rollup_count[tier]++;
+            }
+            memset(bucket, 0, sizeof(luminox_rollup_bucket_t));
+            bucket->start = start;
+        }
+
+        for(uint8_t i = 0; i < LUMINOX_ROLLUP_FIELDS; i++) {
+            if(!(sample->fields & (1 << i))) {
+                continue;
+            }
+            luminox_rollup_stat_t * stat = &bucket->stat[i];
+            float value = luminox_sample_field(sample, i);
+            if(stat->count == 0 || value < stat->min) {
+                stat->min = value;
+            }
+            if(stat->count == 0 || value > stat->max) {
+                stat->max = value;
+            }
+            stat->sum += value;
+            stat->count++;
+        }
+    }
+}
+
+/*
+    @brief Function for getting one bucket of a rollup tier
+
+    @note Every decoded value is added to the current minute and hour buckets as it arrives. Periods in which
+	  no response arrived have no bucket, check start. Requires luminox_get_time, without a time source every
+	  value lands in the bucket starting at 0.
+
+    @param[in] tier Minute or hour tier
+
+    @param[in] age 0 for the current bucket, 1 for the one before and so on
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return Pointer to the bucket, NULL if the tier holds fewer than age + 1 buckets
+*/
+const luminox_rollup_bucket_t * luminox_get_rollup(luminox_rollup_tier_t tier, uint16_t age, luminox_handler_t * luminox_handler) {
+    if(tier >= LUMINOX_ROLLUP_TIER_COUNT || age >= luminox_handler->rollup_count[tier]) {
+        return NULL;
+    }
+    const luminox_rollup_layout_t * layout = &luminox_rollup_layout[tier];
+    uint16_t head = luminox_handler->rollup_head[tier];
+    uint16_t index = (head >= age) ? head - age : head + layout->size - age;
+    return &luminox_handler->rollup[layout->offset + index];
+}
+
+/*
+    @brief Function for getting the number of buckets a rollup tier holds
+
+    @param[in] tier Minute or hour tier
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return Number of buckets, at most LUMINOX_ROLLUP_MINUTES or LUMINOX_ROLLUP_HOURS
+*/
+uint16_t luminox_rollup_count(luminox_rollup_tier_t tier, luminox_handler_t * luminox_handler) {
+    if(tier >= LUMINOX_ROLLUP_TIER_COUNT) {
+        return 0;
+    }
+    return luminox_handler->rollup_count[tier];
+}
+#endif
+
+#ifdef LUMINOX_HISTORY
+/*
+    @brief Function for appending the decoded sample to the history ring
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+static void luminox_history_add(luminox_handler_t * luminox_handler) {
+    luminox_history_t * history = &luminox_handler->history;
+    const luminox_sample_t * sample = &luminox_handler->sample;
+    uint16_t i = history->head;
+
+    history->ppo2[i] = sample->ppo2;
+    history->o2[i] = sample->o2;
+    history->temp[i] = sample->temp;
+    history->barometric_pressure[i] = sample->barometric_pressure;
+    history->status[i] = sample->status;
+    history->timestamp[i] = sample->timestamp;
+    history->fields[i] = sample->fields;
+
+    history->head = (i + 1 < LUMINOX_HISTORY_SIZE) ? i + 1 : 0;
+    if(history->count < LUMINOX_HISTORY_SIZE) {
+        history->count++;
+    }
+}
+#endif
+
+/*
+    @brief Function for handling any unsuccessfull requests
+
+    @note Called in luminox_process_response if an error message is received from the sensor, 
+	  uses what's in luminox_data[] to process the error. An error frame shorter than "E 0x\r"
+	  is reported as LUMINOX_ERR_INVALID_FRAME without reading its code
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return luminox_retcode_t returns one of the defined luminox error codes
+*/
+luminox_retcode_t luminox_error_handler(luminox_handler_t * luminox_handler) {
+    LUMINOX_PROFILE_ENTER();
+    luminox_retcode_t ret = LUMINOX_ERROR;
+    const uint8_t * terminator = memchr(luminox_handler->luminox_data, TERMINATOR, luminox_handler->luminox_data_size);
+    uint16_t len = (terminator != NULL) ? (uint16_t)(terminator - luminox_handler->luminox_data) : luminox_handler->luminox_data_size;
+    if(len < ERROR_RESPONSE_MIN_LEN) {
+        LUMINOX_PROFILE_EXIT(LUMINOX_PROFILE_ERROR_HANDLER);
+        return LUMINOX_ERR_INVALID_FRAME;
+    }
+    switch(luminox_handler->luminox_data[3]) {
+	    case 0x30:
+#ifdef DEBUG_OUTPUT
+	        NRF_LOG_INFO("Error: USART Receiver Overflow");
+		NRF_LOG_FLUSH();
+#endif
+	        ret = LUMINOX_ERR_RX_OVERFLOW;
+	        break;
+	    case 0x31:
+#ifdef DEBUG_OUTPUT
+	        NRF_LOG_INFO("Error: Invalid Command");
+		NRF_LOG_FLUSH();
+#endif
+	        ret = LUMINOX_ERR_INVALID_CMD;
+	        break;
+	    case 0x32:
+#ifdef DEBUG_OUTPUT
+	        NRF_LOG_INFO("Error: Invalid Frame");
+		NRF_LOG_FLUSH();
+#endif
+	        ret = LUMINOX_ERR_INVALID_FRAME;
+	        break;
+	    case 0x33:
+#ifdef DEBUG_OUTPUT
+	        NRF_LOG_INFO("Error: Invalid Argument");
+		NRF_LOG_FLUSH();
+#endif
+	        ret = LUMINOX_ERR_INVALID_ARG;
+	        break;
+    }
+    LUMINOX_PROFILE_EXIT(LUMINOX_PROFILE_ERROR_HANDLER);
+    return ret;
+}
+
+/*
+    @brief Function for getting the identity of the sensor
+
+    @note Filled in by the responses to luminox_request_sensor_info(), luminox_init() requests all of them
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return Pointer to the date of manufacture, serial number and software revision strings
+*/
+const luminox_identity_t * luminox_get_identity(luminox_handler_t * luminox_handler) {
+    return &luminox_handler->identity;
+}
+
+/*
+    @brief Function for selecting the calibration entry matching the serial number of the sensor
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+static void luminox_select_calibration(luminox_handler_t * luminox_handler) {
+    luminox_handler->active_calibration = NULL;
+    if(luminox_handler->identity.serial_number[0] == '\0') {
+        return;
+    }
+    for(uint8_t i = 0; i < luminox_handler->calibration_count; i++) {
+        if(strncmp(luminox_handler->calibration[i].serial_number, luminox_handler->identity.serial_number, LUMINOX_INFO_SIZE) == 0) {
+            luminox_handler->active_calibration = &luminox_handler->calibration[i];
+            return;
+        }
+    }
+}
+
+/*
+    @brief Function for reading a little endian int32 from a blob
+
+    @param[in] p Pointer to the first byte
+
+    @return Decoded value
+*/
+static int32_t luminox_read_int32(const uint8_t * p) {
+    return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+/*
+    @brief Function for writing a little endian int32 to a blob
+
+    @param[out] p Pointer to the first byte
+
+    @param[in] value Value to encode
+*/
+static void luminox_write_int32(uint8_t * p, int32_t value) {
+    uint32_t u = (uint32_t)value;
+    p[0] = (uint8_t)u;
+    p[1] = (uint8_t)(u >> 8);
+    p[2] = (uint8_t)(u >> 16);
+    p[3] = (uint8_t)(u >> 24);
+}
+
+/*
+    @brief Function for loading the calibration table from a blob
+
+    @note Replaces the whole table and selects the entry matching the serial number of the sensor.
+	  The blob starts with LUMINOX_CALIBRATION_BLOB_VERSION and the entry count, followed by one entry per
+	  LUMINOX_CALIBRATION_BLOB_ENTRY_SIZE bytes: the serial number, then the offset and gain of every
+	  field as little endian int32. luminox_init() clears the table, so load it afterwards.
+
+    @param[in] blob Calibration blob, as written by luminox_save_calibration()
+
+    @param[in] size Size of the blob in bytes
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return luminox_retcode_t Success, LUMINOX_ERR_FULL for more than LUMINOX_MAX_CALIBRATIONS entries or
+			      LUMINOX_ERROR for a malformed blob
+*/
+luminox_retcode_t luminox_load_calibration(const uint8_t * blob, uint16_t size, luminox_handler_t * luminox_handler) {
+    if(size < LUMINOX_CALIBRATION_BLOB_HEADER_SIZE || blob[0] != LUMINOX_CALIBRATION_BLOB_VERSION) {
+        return LUMINOX_ERROR;
+    }
+    uint8_t count = blob[1];
+    if(count > LUMINOX_MAX_CALIBRATIONS) {
+        return LUMINOX_ERR_FULL;
+    }
+    if(size < LUMINOX_CALIBRATION_BLOB_HEADER_SIZE + count * LUMINOX_CALIBRATION_BLOB_ENTRY_SIZE) {
+        return LUMINOX_ERROR;
+    }
+
+    const uint8_t * p = blob + LUMINOX_CALIBRATION_BLOB_HEADER_SIZE;
+    for(uint8_t i = 0; i < count; i++) {
+        luminox_calibration_t * entry = &luminox_handler->calibration[i];
+        memcpy(entry->serial_number, p, LUMINOX_INFO_SIZE);
+        entry->serial_number[LUMINOX_INFO_SIZE - 1] = '\0';
+        p += LUMINOX_INFO_SIZE;
+        for(uint8_t f = 0; f < LUMINOX_CALIBRATION_FIELDS; f++) {
+            entry->offset[f] = luminox_read_int32(p);
+            entry->gain[f] = luminox_read_int32(p + 4);
+            p += 8;
+        }
+    }
+    luminox_handler->calibration_count = count;
+    luminox_select_calibration(luminox_handler);
+
+    return LUMINOX_SUCCESS;
+}
+
+/*
+    @brief Function for saving the calibration table to a blob
+
+    @param[out] blob Buffer to write the blob to
+
+    @param[in] size Size of the buffer in bytes
+
+    @param[out] written Number of bytes written to blob
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return luminox_retcode_t Either success or LUMINOX_ERR_FULL if the buffer is too small
+*/
+luminox_retcode_t luminox_save_calibration(uint8_t * blob, uint16_t size, uint16_t * written, luminox_handler_t * luminox_handler) {
+    uint16_t needed = LUMINOX_CALIBRATION_BLOB_HEADER_SIZE + luminox_handler->calibration_count * LUMINOX_CALIBRATION_BLOB_ENTRY_SIZE;
+    *written = 0;
+    if(size < needed) {
+        return LUMINOX_ERR_FULL;
+    }
+
+    blob[0] = LUMINOX_CALIBRATION_BLOB_VERSION;
+    blob[1] = luminox_handler->calibration_count;
+    uint8_t * p = blob + LUMINOX_CALIBRATION_BLOB_HEADER_SIZE;
+    for(uint8_t i = 0; i < luminox_handler->calibration_count; i++) {
+        const luminox_calibration_t * entry = &luminox_handler->calibration[i];
+        memcpy(p, entry->serial_number, LUMINOX_INFO_SIZE);
+        p += LUMINOX_INFO_SIZE;
+        for(uint8_t f = 0; f < LUMINOX_CALIBRATION_FIELDS; f++) {
+            luminox_write_int32(p, entry->offset[f]);
+            luminox_write_int32(p + 4, entry->gain[f]);
+            p += 8;
+        }
+    }
+    *written = needed;
+
+    return LUMINOX_SUCCESS;
+}
+
+/*
+    @brief Function for setting the temperature compensation curve of the sensor
+
+    @note Applied to ppO2 and O2 in fixed point while decoding, after the calibration, using the temperature of the
+	  same response or the last one decoded before it. The values before compensation stay in sample.ppo2_raw and
+	  sample.o2_raw. The curve is cleared by luminox_init(), so call it afterwards.
+
+    @param[in] points Points of the curve in ascending temperature order, copied into the handler
+
+    @param[in] count Number of points, 0 to turn compensation off
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return luminox_retcode_t Either success or LUMINOX_ERR_INVALID_ARG if there are too many points
+			      or they aren't in ascending temperature order
+*/
+luminox_retcode_t luminox_set_temp_compensation(const luminox_compensation_point_t * points, uint8_t count, luminox_handler_t * luminox_handler) {
+    if(count > LUMINOX_MAX_COMPENSATION_POINTS) {
+        return LUMINOX_ERR_INVALID_ARG;
+    }
+    for(uint8_t i = 1; i < count; i++) {
+        if(points[i].temp <= points[i - 1].temp) {
+            return LUMINOX_ERR_INVALID_ARG;
+        }
+    }
+    memcpy(luminox_handler->compensation, points, count * sizeof(luminox_compensation_point_t));
+    luminox_handler->compensation_count = count;
+    return LUMINOX_SUCCESS;
+}
+
+/*
+    @brief Function for applying the sensor's calibration to a decoded value
+
+    @param[in] index Bit number of the luminox_field_t the value belongs to
+
+    @param[in] value Decoded value in hundredths
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return Corrected value in hundredths, value itself if the sensor has no calibration entry
+*/
+static int32_t luminox_calibrate(uint8_t index, int32_t value, luminox_handler_t * luminox_handler) {
+    const luminox_calibration_t * calibration = luminox_handler->active_calibration;
+    if(calibration == NULL) {
+        return value;
+    }
+    return (int32_t)(((int64_t)value * calibration->gain[index]) >> 16) + calibration->offset[index];
+}
+
+/*
+    @brief Function for applying the temperature compensation curve to the ppO2 and O2 of the last response
+
+    @note Runs after the whole response was decoded, because an "A" response is "O T P % e" and its temperature
+	  follows the ppO2
+
+    @param[in] ppo2 Calibrated ppO2 of the response in hundredths, ignored if the response held none
+
+    @param[in] o2 Calibrated O2 of the response in hundredths, ignored if the response held none
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+static void luminox_compensate(int32_t ppo2, int32_t o2, luminox_handler_t * luminox_handler) {
+    luminox_sample_t * sample = &luminox_handler->sample;
+    const luminox_compensation_point_t * points = luminox_handler->compensation;
+    uint8_t last = luminox_handler->compensation_count - 1;
+    int32_t temp = luminox_handler->temp_hundredths;
+    int32_t gain;
+
+    if(luminox_handler->compensation_count == 0 || !luminox_handler->temp_known || !(sample->fields & (LUMINOX_FIELD_PPO2 | LUMINOX_FIELD_O2))) {
+        return;
+    }
+
+    if(temp <= points[0].temp) {
+        gain = points[0].gain;
+    } else if(temp >= points[last].temp) {
+        gain = points[last].gain;
+    } else {
+        uint8_t k = 1;
+        while(temp > points[k].temp) {
+            k++;
+        }
+        gain = points[k - 1].gain + (int32_t)((int64_t)(points[k].gain - points[k - 1].gain) * (temp - points[k - 1].temp)
+            / (points[k].temp - points[k - 1].temp));
+    }
+
+    if(sample->fields & LUMINOX_FIELD_PPO2) {
+        sample->ppo2 = (int32_t)(((int64_t)ppo2 * gain) >> 16) / 100.0f;
+    }
+    if(sample->fields & LUMINOX_FIELD_O2) {
+        sample->o2 = (int32_t)(((int64_t)o2 * gain) >> 16) / 100.0f;
+    }
+}
+
+/*
+    @brief Function for checking that a field of the response is a placeholder such as "------"
+
+    @param[in] field Pointer to the first character of the field
+
+    @param[in] width Number of characters in the field
+
+    @return true if every character is '-'
+*/
+static bool luminox_is_placeholder(const uint8_t * field, uint8_t width) {
+    for(uint8_t i = 0; i < width; i++) {
+        if(field[i] != '-') {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+    @brief Function for converting an ASCII field of the response into a fixed point value
+
+    @note Accepts an optional sign, digits and a decimal point, and stops at the first other character.
+	  Digits past the second decimal place are ignored. Never reads more than width bytes.
+
+    @param[in] field Pointer to the first character of the field
+
+    @param[in] width Maximum number of characters in the field
+
+    @param[out] value Field value in hundredths (213.1 becomes 21310)
+
+    @return true if the field held at least one digit, false for placeholders such as "------"
+*/
+static bool luminox_parse_field(const uint8_t * field, uint8_t width, int32_t * value) {
+    int32_t result = 0;
+    int8_t decimals = -1; // -1 until the decimal point is seen
+    bool negative = false;
+    bool digits = false;
+    uint8_t i = 0;
+
+    if(width > 0 && (field[0] == '-' || field[0] == '+')) {
+        negative = (field[0] == '-');
+        i++;
+    }
+    for(; i < width; i++) {
+        if(field[i] >= '0' && field[i] <= '9') {
+            if(decimals < 2) {
+                result = result * 10 + (field[i] - '0');
+                if(decimals >= 0) {
+                    decimals++;
+                }
+            }
+            digits = true;
+        } else if(field[i] == '.' && decimals < 0) {
+            decimals = 0;
+        } else {
+            break;
+        }
+    }
+    // scale to hundredths
+    for(int8_t d = (decimals < 0) ? 0 : decimals; d < 2; d++) {
+        result *= 10;
+    }
+
+    *value = negative ? -result : result;
+    return digits;
+}
+
+/*
+    @brief Function for decoding the response in luminox_data into the sample
+
+    @note Sets err_code and the sample's fields mask, see luminox_process_response()
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+static void luminox_parse_response(luminox_handler_t * luminox_handler) {
+    const uint8_t * data = luminox_handler->luminox_data;
+    uint16_t i = 0;
+    int32_t value;
+    int32_t ppo2 = 0; // calibrated values in hundredths, compensated once the temperature is known
+    int32_t o2 = 0;
+    luminox_handler->sample.fields = 0;
+    luminox_handler->sample.exceptions = 0;
+    luminox_handler->sample.missing = 0;
+
+    // find the terminator first so nothing below reads past the received bytes
+    const uint8_t * terminator = memchr(data, TERMINATOR, luminox_handler->luminox_data_size);
+    if(terminator == NULL) {
+#ifdef DEBUG_OUTPUT
+        NRF_LOG_INFO("Response without terminator");
+        NRF_LOG_FLUSH();
+#endif
+        luminox_handler->err_code = LUMINOX_ERR_RX_OVERFLOW;
+        return;
+    }
+    uint16_t len = (uint16_t)(terminator - data);
+
+    while(i < len) {
+        switch(data[i]) {
+	        case ERROR_RESPONSE:
+		        luminox_handler->err_code = luminox_error_handler(luminox_handler);
+		        return; // stop processing, the rest of the message is the error code
+            case MODE_OUTPUT:
+                if(i + 3 >= len) {
+                    goto InvalidFrame;
+                }
+                switch(data[i+3]) {
+                    case 0x30:
+                        luminox_handler->current_mode = LUMINOX_MODE_STREAMING; // update current mode
+#ifdef DEBUG_OUTPUT
+        		        NRF_LOG_INFO("Mode changed to streaming mode.");
+				NRF_LOG_FLUSH();
+#endif
+        		        break;
+        	        case 0x31:
+			            luminox_handler->current_mode = LUMINOX_MODE_POLLING; // update current mode
+#ifdef DEBUG_OUTPUT
+        		        NRF_LOG_INFO("Mode changed to polling mode.");
+				NRF_LOG_FLUSH();
+#endif
+        		        break;
+        	        case 0x32:
+			            luminox_handler->current_mode = LUMINOX_MODE_OFF; // update current mode
+#ifdef DEBUG_OUTPUT
+        		        NRF_LOG_INFO("Mode changed to off.");
+				NRF_LOG_FLUSH();
+#endif
+        		        break;
+        	    }
+        	    goto EndWhile; // break out of while loop (to stop printing rest of message)
+            case PPO2:
+                if(i + 2 + PPO2_WIDTH > len) {
+                    goto InvalidFrame;
+                }
+                i += 2; // increment by  2 to move the index to the start of the actual ppO2 data
+                if(luminox_parse_field(&data[i], PPO2_WIDTH, &value)) { // turn ascii response into a fixed point value
+                    value = luminox_calibrate(0, value, luminox_handler);
+                    ppo2 = value;
+                    luminox_handler->sample.ppo2 = value / 100.0f; // update value
+                    luminox_handler->sample.ppo2_raw = luminox_handler->sample.ppo2;
+                    luminox_handler->sample.fields |= LUMINOX_FIELD_PPO2;
+#ifdef DEBUG_OUTPUT
+                    NRF_LOG_INFO("ppO2 Value: " NRF_LOG_FLOAT_MARKER " mbar", NRF_LOG_FLOAT(luminox_handler->sample.ppo2));
+                    NRF_LOG_FLUSH();
+#endif
+                } else {
+                    luminox_handler->sample.missing |= LUMINOX_FIELD_PPO2; // placeholder such as "------"
+                }
+                i += PPO2_WIDTH - 1; // move the index to the end of the string or next value in the response
+                break;
+            case O2:
+                if(i + 2 + O2_WIDTH > len) {
+                    goto InvalidFrame;
+                }
+                i += 2;
+                if(luminox_parse_field(&data[i], O2_WIDTH, &value)) {
+                    value = luminox_calibrate(1, value, luminox_handler);
+                    o2 = value;
+                    luminox_handler->sample.o2 = value / 100.0f;
+                    luminox_handler->sample.o2_raw = luminox_handler->sample.o2;
+                    luminox_handler->sample.fields |= LUMINOX_FIELD_O2;
+#ifdef DEBUG_OUTPUT
+                    NRF_LOG_INFO("o2 Value: " NRF_LOG_FLOAT_MARKER " %", NRF_LOG_FLOAT(luminox_handler->sample.o2));
+                    NRF_LOG_FLUSH();
+#endif
+                } else {
+                    luminox_handler->sample.missing |= LUMINOX_FIELD_O2; // placeholder such as "------"
+                }
+                i += O2_WIDTH - 1;
+                break;
+            case TEMPERATURE:
+                if(i + 2 + TEMPERATURE_WIDTH > len) {
+                    goto InvalidFrame;
+                }
+                i += 2;
+                if(luminox_parse_field(&data[i], TEMPERATURE_WIDTH, &value)) {
+                    value = luminox_calibrate(2, value, luminox_handler);
+                    luminox_handler->sample.temp = value / 100.0f;
+                    luminox_handler->temp_hundredths = value;
+                    luminox_handler->temp_known = true;
+                    luminox_handler->sample.fields |= LUMINOX_FIELD_TEMP;
+#ifdef DEBUG_OUTPUT
+                    NRF_LOG_INFO("Temperature: " NRF_LOG_FLOAT_MARKER " C", NRF_LOG_FLOAT(luminox_handler->sample.temp));
+                    NRF_LOG_FLUSH();
+#endif
+                } else {
+                    luminox_handler->sample.missing |= LUMINOX_FIELD_TEMP; // placeholder such as "------"
+                }
+                i += TEMPERATURE_WIDTH - 1;
+                break;
+            case BAROMETRIC_PRESSURE:
+                // sensor without barometric pressure sensor, step over the "------" placeholder without decoding it
+                if(i + 2 + BAROMETRIC_PRESSURE_MISSING_WIDTH <= len
+                    && luminox_is_placeholder(&data[i + 2], BAROMETRIC_PRESSURE_MISSING_WIDTH)) {
+                    i += 2 + BAROMETRIC_PRESSURE_MISSING_WIDTH - 1;
+                    luminox_handler->sample.missing |= LUMINOX_FIELD_BAROMETRIC_PRESSURE;
+#ifndef LUMINOX_NO_BAROMETRIC
+                    if(luminox_handler->variant == LUMINOX_VARIANT_UNKNOWN) {
+                        luminox_handler->variant = LUMINOX_VARIANT_NO_BAROMETRIC;
+                    }
+#endif
+                    break;
+                }
+#ifndef LUMINOX_NO_BAROMETRIC
+                if(i + 2 + BAROMETRIC_PRESSURE_WIDTH > len) {
+                    goto InvalidFrame;
+                }
+                i += 2;
+                if(luminox_parse_field(&data[i], BAROMETRIC_PRESSURE_WIDTH, &value)) {
+                    value = luminox_calibrate(3, value, luminox_handler);
+                    luminox_handler->sample.barometric_pressure = value / 100.0f;
+                    luminox_handler->sample.fields |= LUMINOX_FIELD_BAROMETRIC_PRESSURE;
+                    luminox_handler->variant = LUMINOX_VARIANT_BAROMETRIC; // also recovers from a misdetection
+#ifdef DEBUG_OUTPUT
+                    NRF_LOG_INFO("Barometric Pressure: " NRF_LOG_FLOAT_MARKER " mbar", NRF_LOG_FLOAT(luminox_handler->sample.barometric_pressure));
+                    NRF_LOG_FLUSH();
+#endif
+                } else {
+                    luminox_handler->sample.missing |= LUMINOX_FIELD_BAROMETRIC_PRESSURE; // other placeholder
+                }
+                i += BAROMETRIC_PRESSURE_WIDTH - 1;
+#else
+                // the decoder is compiled out, skip whatever the sensor sent up to the next field
+                i += 2;
+                while(i < len && data[i] != SEPARATOR) {
+                    i++;
+                }
+                i--;
+                luminox_handler->sample.missing |= LUMINOX_FIELD_BAROMETRIC_PRESSURE;
+#endif
+                break;
+            case SEPARATOR:
+#ifdef DEBUG_OUTPUT
+		NRF_LOG_INFO(" ");
+		NRF_LOG_FLUSH();
+#endif
+		break;
+            case SENSOR_STATUS:
+                if(i + 2 + SENSOR_STATUS_WIDTH > len) {
+                    goto InvalidFrame;
+                }
+                i += 2;
+                if(luminox_parse_field(&data[i], SENSOR_STATUS_WIDTH, &value)) {
+                    luminox_handler->sample.status = (uint16_t)(value / 100);
+                    luminox_handler->sample.fields |= LUMINOX_FIELD_STATUS;
+#ifdef DEBUG_OUTPUT
+                    NRF_LOG_INFO("Sensor Status: %d", luminox_handler->sample.status);
+                    NRF_LOG_FLUSH();
+#endif
+                } else {
+                    luminox_handler->sample.missing |= LUMINOX_FIELD_STATUS; // placeholder such as "------"
+                }
+                i += SENSOR_STATUS_WIDTH - 1;
+                break;
+	    case SENSOR_INFORMATION: {
+                char * info;
+                switch(luminox_handler->pending_info) {
+                    case LUMINOX_INFO_DATE_OF_MFG:
+                        info = luminox_handler->identity.date_of_mfg;
+                        break;
+                    case LUMINOX_INFO_SERIAL_NUM:
+                        info = luminox_handler->identity.serial_number;
+                        break;
+                    default:
+                        info = luminox_handler->identity.sw_version;
+                        break;
+                }
+                // the information is the rest of the response without the trailing "\r"
+                uint16_t info_len = (i + 2 < len) ? len - (i + 2) : 0;
+                if(info_len > 0 && data[i + 2 + info_len - 1] == '\r') {
+                    info_len--;
+                }
+                if(info_len > LUMINOX_INFO_SIZE - 1) {
+                    info_len = LUMINOX_INFO_SIZE - 1;
+                }
+                memcpy(info, &data[i + 2], info_len);
+                info[info_len] = '\0';
+#ifdef DEBUG_OUTPUT
+                NRF_LOG_INFO("%s", info);
+                NRF_LOG_FLUSH();
+#endif
+                if(luminox_handler->pending_info == LUMINOX_INFO_SERIAL_NUM) {
+                    luminox_select_calibration(luminox_handler);
+                }
+                goto EndWhile; // the information can contain any character, don't decode it as fields
+            }
+            default:
+#ifdef DEBUG_OUTPUT
+	    NRF_LOG_INFO("%c", data[i]);
+	    NRF_LOG_FLUSH();
+#endif
+	    break;
+        }
+
+        i++;
+    }
+    EndWhile: ;
+#ifdef DEBUG_OUTPUT
+    NRF_LOG_INFO("");
+#endif
+    luminox_compensate(ppo2, o2, luminox_handler);
+    luminox_handler->err_code = LUMINOX_SUCCESS;
+    return;
+
+    InvalidFrame:
+#ifdef DEBUG_OUTPUT
+    NRF_LOG_INFO("Truncated field in response");
+    NRF_LOG_FLUSH();
+#endif
+    luminox_handler->err_code = LUMINOX_ERR_INVALID_FRAME;
+}
+
+/*
+    @brief Function for printing the response from the luminox sensor
+
+    @note The LuminOx sensor responds in ASCII encoded messages
+
+    @note Updates the sample and err_code, then calls the subscribers of the updated fields
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+void luminox_process_response(luminox_handler_t * luminox_handler) {
+    LUMINOX_PROFILE_ENTER();
+    uint32_t now = luminox_now(luminox_handler);
+    if(luminox_handler->request_pending) {
+        luminox_handler->response_latency = now - luminox_handler->request_time;
+        luminox_handler->request_pending = false;
+    }
+
+    luminox_trace(LUMINOX_TRACE_PARSE_START, luminox_handler);
+    luminox_parse_response(luminox_handler);
+    if(luminox_handler->err_code == LUMINOX_SUCCESS) {
+        luminox_filter_spikes(luminox_handler);
+    }
+    luminox_trace(LUMINOX_TRACE_PARSE_END, luminox_handler);
+
+    if(luminox_handler->err_code == LUMINOX_SUCCESS && (luminox_handler->sample.fields | luminox_handler->sample.missing)) {
+        luminox_handler->sample.sequence++; // invalidates the derived values
+        luminox_handler->fields_seen |= luminox_handler->sample.fields;
+        if(luminox_handler->sample.fields & LUMINOX_FIELD_BAROMETRIC_PRESSURE) {
+            luminox_handler->barometric_pressure_valid = true;
+        } else if(luminox_handler->sample.missing & LUMINOX_FIELD_BAROMETRIC_PRESSURE) {
+            luminox_handler->barometric_pressure_valid = false;
+        }
+    }
+
+    if(luminox_handler->err_code == LUMINOX_SUCCESS && luminox_handler->sample.fields) {
+        luminox_handler->sample.timestamp = luminox_handler->rx_frame_time; // not the time the application got to it
+        luminox_apply_deadband(luminox_handler);
+#ifdef LUMINOX_HISTORY
+        luminox_history_add(luminox_handler);
+#endif
+#ifdef LUMINOX_ROLLUPS
+        luminox_rollup_add(luminox_handler);
+#endif
+        luminox_quantiles_add(luminox_handler);
+        luminox_trace(LUMINOX_TRACE_DISPATCH_START, luminox_handler);
+        luminox_notify_subscribers(luminox_handler);
+        luminox_batch_sample(luminox_handler);
+        luminox_trace(LUMINOX_TRACE_DISPATCH_END, luminox_handler);
+    } else if(luminox_handler->err_code == LUMINOX_SUCCESS && luminox_handler->sample.possible_steps) {
+        // every value was held back, but a possible step is news to the subscribers
+        luminox_handler->sample.timestamp = luminox_handler->rx_frame_time;
+        luminox_trace(LUMINOX_TRACE_DISPATCH_START, luminox_handler);
+        luminox_notify_subscribers(luminox_handler);
+        luminox_trace(LUMINOX_TRACE_DISPATCH_END, luminox_handler);
+    }
+
+    if(luminox_handler->sequence != NULL) {
+        luminox_sequence_advance(luminox_handler); // send the next request of a non-blocking sequence
+    }
+    LUMINOX_PROFILE_EXIT(LUMINOX_PROFILE_PROCESS_RESPONSE);
+}
+
+/*
+    @brief Function for clearing the state of the handler before the initialization requests
+
+    @note Clears the subscriber table, deadbands, batching, identity, calibration, request tracking and statistics
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+static void luminox_init_reset(luminox_handler_t * luminox_handler) {
+    // clear subscriber table, deadbands, batching, identity, calibration and request tracking
+    luminox_handler->subscriber_count = 0;
+    memset(luminox_handler->deadband, 0, sizeof(luminox_handler->deadband));
+    luminox_handler->quantile_count = 0;
+    memset(luminox_handler->spike_filter, 0, sizeof(luminox_handler->spike_filter));
+    memset(&luminox_handler->identity, 0, sizeof(luminox_identity_t));
+    luminox_handler->calibration_count = 0;
+    luminox_handler->active_calibration = NULL;
+    luminox_handler->compensation_count = 0;
+    luminox_handler->temp_known = false;
+#ifdef LUMINOX_HISTORY
+    luminox_handler->history.head = 0;
+    luminox_handler->history.count = 0;
+#endif
+#ifdef LUMINOX_ROLLUPS
+    memset(luminox_handler->rollup_count, 0, sizeof(luminox_handler->rollup_count));
+#endif
+    luminox_handler->barometric_pressure_valid = false;
+    luminox_handler->external_pressure = 0;
+    luminox_handler->derived_valid = false;
+    luminox_handler->fields_seen = 0;
+    luminox_handler->batch = NULL;
+    luminox_handler->batch_count = 0;
+    luminox_handler->request_pending = false;
+    luminox_handler->response_latency = 0;
+    luminox_handler->sequence = NULL;
+    luminox_handler->replay_active = false;
+    luminox_handler->luminox_data_size = 0;
+    luminox_handler->rx_index = 0;
+    memset(luminox_handler->bus_slots, 0, sizeof(luminox_handler->bus_slots));
+    luminox_handler->bus_slot = luminox_now(luminox_handler) / LUMINOX_BUS_SLOT_MS;
+    luminox_handler->bus_slots_used = 0;
+    luminox_handler->tx_bytes_total = 0;
+    luminox_handler->rx_bytes_total = 0;
+#ifdef LUMINOX_PROFILING
+    luminox_reset_profile(luminox_handler);
+#endif
+#ifdef LUMINOX_NO_BAROMETRIC
+    luminox_handler->variant = LUMINOX_VARIANT_NO_BAROMETRIC;
+#else
+    luminox_handler->variant = LUMINOX_VARIANT_UNKNOWN; // detected from the pressure response
+#endif
+}
+
+/*
+    @brief Function for resetting the measurements after the initialization requests
+
+    @param[in] luminox_handler Pointer of library handler
+*/
+static void luminox_init_finish(luminox_handler_t * luminox_handler) {
+    luminox_handler->current_mode = LUMINOX_MODE_DEFAULT;
+
+    // set measurements to 0
+    memset(&luminox_handler->sample, 0, sizeof(luminox_sample_t));
+    luminox_handler->derived_sequence = 0; // nothing to derive from until the first response
+    luminox_handler->derived_valid = false;
+    luminox_handler->barometric_pressure_valid = false;
+    memset(luminox_handler->luminox_data, 0, UART_RX_BUF_SIZE * sizeof(uint8_t));
+    luminox_handler->luminox_data_size = 0;
+
+    // forget the pressure response that detected the variant, it is not a measurement of the application
+#ifdef LUMINOX_HISTORY
+    luminox_handler->history.head = 0;
+    luminox_handler->history.count = 0;
+#endif
+#ifdef LUMINOX_ROLLUPS
+    memset(luminox_handler->rollup_head, 0, sizeof(luminox_handler->rollup_head));
+    memset(luminox_handler->rollup_count, 0, sizeof(luminox_handler->rollup_count));
+#endif
+
+    // set error code to success
+    luminox_handler->err_code = LUMINOX_SUCCESS;
+}
+
+/*
+    @brief Function for initializing communication with the LuminOx sensor
+
+    @note First sets the output mode to polling to request and print out sensor information, then sets the output mode
+	  to default mode, which is set to be off. Then resets all of the static variables keeping track of state and recent sensor readings.
+
+    @note Also requests the barometric pressure to detect whether the sensor has a barometric pressure sensor,
+	  unless LUMINOX_NO_BAROMETRIC pins the variant at compile time.
 
     @param[in] luminox_handler Pointer of library handler
 */
@@ -474,6 +2555,8 @@ void luminox_init(luminox_handler_t * luminox_handler) {
     NRF_LOG_FLUSH();
 #endif
 
+    luminox_init_reset(luminox_handler);
+
     // set output mode to polling
     luminox_handler->err_code = luminox_set_ouput_mode(LUMINOX_MODE_POLLING, luminox_handler);
 
@@ -488,19 +2571,43 @@ void luminox_init(luminox_handler_t * luminox_handler) {
 
     luminox_request_sensor_info(LUMINOX_INFO_SW_VER, luminox_handler);
 
+#ifndef LUMINOX_NO_BAROMETRIC
+    // detect the variant from the pressure response, "------" means there is no barometric pressure sensor
+    luminox_request_barometric_pressure(luminox_handler);
+#endif
+
     // set output mode to default
     luminox_set_ouput_mode(LUMINOX_MODE_DEFAULT, luminox_handler);
-    luminox_handler->current_mode = LUMINOX_MODE_DEFAULT;
-    
-    // set measurements to 0
-    luminox_handler->current_ppO2 = 0;
-    luminox_handler->current_O2 = 0;
-    luminox_handler->current_temp = 0;
-    luminox_handler->current_barometric_pressure = 0;
-    memset(luminox_handler->luminox_data, 0, UART_RX_BUF_SIZE * sizeof(uint8_t));
 
-    // set error code to success
-    luminox_handler->err_code = LUMINOX_SUCCESS;
+    luminox_init_finish(luminox_handler);
+}
+
+/*
+    @brief Function for starting a non-blocking initialization of the LuminOx sensor
+
+    @note Sends the same requests as luminox_init() one at a time, each after luminox_process_response() handled the
+	  response of the one before, so many sensors can be brought up at once from one loop. The handler is
+	  initialized once luminox_sequence_busy() returns false and luminox_sequence_result() is LUMINOX_SUCCESS.
+
+    @note luminox_tx must not block. It is called from inside luminox_process_response() for every request after the
+	  first, so a luminox_tx that waits for the response (like the blocking uart_write() in the README) stalls
+	  the loop and brings the sensors up one after another. Copy the request, which is only valid during the
+	  call, into the port's TX buffer, start the transfer and return, e.g.
+	      void uart_write_async(unsigned char * tx, uint8_t size) {
+	          memcpy(port_tx_buf, tx, size);
+	          uart_tx_start(port_tx_buf, size); // interrupt or DMA driven, returns at once
+	      }
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @return luminox_retcode_t Either success or LUMINOX_ERROR if a sequence is already running
+*/
+luminox_retcode_t luminox_init_start(luminox_handler_t * luminox_handler) {
+    if(luminox_handler->sequence != NULL) {
+        return LUMINOX_ERROR;
+    }
+    luminox_init_reset(luminox_handler);
+    return luminox_sequence_start(luminox_init_sequence, luminox_handler);
 }
 
 /*
@@ -513,9 +2620,101 @@ void luminox_init(luminox_handler_t * luminox_handler) {
     @param[in] luminox_handler Pointer of library handler
 
     @note call this function in your uart_event_handler when a complete response from the sensor has been recognized
+
+    @note The sample is timestamped with the time of this call minus the time the response took on the line,
+	  so call it as soon as the terminator arrives
 */
 void luminox_update_data(uint8_t * p_response, uint8_t size, luminox_handler_t * luminox_handler) {
-    memcpy(luminox_handler->luminox_data, p_response, size);
+    // only the end of the response was seen, the sensor started sending it one transit time earlier
+    luminox_handler->rx_frame_time = luminox_back_date(luminox_now(luminox_handler), size, luminox_handler);
+    // the whole response arrives at once, so its first byte and terminator are traced together
+    luminox_trace(LUMINOX_TRACE_RX_FIRST_BYTE, luminox_handler);
+    luminox_trace(LUMINOX_TRACE_RX_TERMINATOR, luminox_handler);
+    luminox_store_response(p_response, size, luminox_handler);
+}
+
+/*
+    @brief Function for receiving the response from the LuminOx sensor one byte at a time
+
+    @param[in] byte Byte received from the sensor
+
+    @param[in] luminox_handler Pointer of library handler
+
+    @note Call this function in your uart_event_handler for every received byte instead of luminox_update_data().
+	  Bytes are collected in rx_buffer and copied to luminox_data once the terminator arrives.
+	  The sample is timestamped with the arrival of the first byte, back-dated by that byte's time on the line,
+	  however late luminox_process_response() is called.
+
+    @return true if the byte completed a response and luminox_process_response() can be called
+*/
+bool luminox_receive_byte(uint8_t byte, luminox_handler_t * luminox_handler) {
+    if(luminox_handler->rx_index == 0) {
+        luminox_handler->rx_first_byte_time = luminox_now(luminox_handler);
+        luminox_trace(LUMINOX_TRACE_RX_FIRST_BYTE, luminox_handler);
+    }
+    luminox_handler->rx_buffer[luminox_handler->rx_index++] = byte;
+
+    if(byte == TERMINATOR) {
+        luminox_trace(LUMINOX_TRACE_RX_TERMINATOR, luminox_handler);
+        // the first byte arrives once its own bits are on the line
+        luminox_handler->rx_frame_time = luminox_back_date(luminox_handler->rx_first_byte_time, 1, luminox_handler);
+        luminox_store_response(luminox_handler->rx_buffer, luminox_handler->rx_index, luminox_handler);
+        luminox_handler->rx_index = 0;
+        return true;
+    }
+    if(luminox_handler->rx_index >= UART_RX_BUF_SIZE) {
+#ifdef DEBUG_OUTPUT
+        NRF_LOG_INFO("RX buffer overflow, response dropped");
+        NRF_LOG_FLUSH();
+#endif
+        luminox_handler->err_code = LUMINOX_ERR_RX_OVERFLOW; // no terminator before the buffer filled up
+        luminox_handler->rx_index = 0;
+    }
+    return false;
+}
+
+/*
+    @brief Function for getting the name of a trace event
+
+    @param[in] event Trace event
+
+    @return Name of the span the event starts or ends, "unknown" for an invalid event
+*/
+const char * luminox_trace_event_name(luminox_trace_event_t event) {
+    switch(event) {
+        case LUMINOX_TRACE_TX_START:
+        case LUMINOX_TRACE_TX_END:
+            return "tx";
+        case LUMINOX_TRACE_RX_FIRST_BYTE:
+        case LUMINOX_TRACE_RX_TERMINATOR:
+            return "rx";
+        case LUMINOX_TRACE_PARSE_START:
+        case LUMINOX_TRACE_PARSE_END:
+            return "parse";
+        case LUMINOX_TRACE_DISPATCH_START:
+        case LUMINOX_TRACE_DISPATCH_END:
+            return "dispatch";
+    }
+    return "unknown";
+}
+
+/*
+    @brief Function for getting the Chrome trace event phase of a trace event
+
+    @param[in] event Trace event
+
+    @return 'B' for events that start a span, 'E' for events that end one
+*/
+char luminox_trace_event_phase(luminox_trace_event_t event) {
+    switch(event) {
+        case LUMINOX_TRACE_TX_START:
+        case LUMINOX_TRACE_RX_FIRST_BYTE:
+        case LUMINOX_TRACE_PARSE_START:
+        case LUMINOX_TRACE_DISPATCH_START:
+            return 'B';
+        default:
+            return 'E';
+    }
 }
 
 /*
@@ -524,6 +2723,7 @@ void luminox_update_data(uint8_t * p_response, uint8_t size, luminox_handler_t *
     @param[in] luminox_handler Pointer of library handler
 */
 luminox_retcode_t luminox_wait_for_response(luminox_handler_t * luminox_handler) {
+    LUMINOX_PROFILE_ENTER();
     uint32_t timer = 0;
     while(!luminox_complete_uart_rx) {
          if(timer >= RESPONSE_TIMEOUT) {
@@ -531,10 +2731,12 @@ luminox_retcode_t luminox_wait_for_response(luminox_handler_t * luminox_handler)
              NRF_LOG_INFO("UART Response Timeout");
  #endif
              luminox_handler->err_code = LUMINOX_ERR_TIMEOUT; // timeout
+             LUMINOX_PROFILE_EXIT(LUMINOX_PROFILE_WAIT_FOR_RESPONSE);
              return LUMINOX_ERR_TIMEOUT;
          }
          timer++;
     }
     luminox_complete_uart_rx = false; // reset flag
+    LUMINOX_PROFILE_EXIT(LUMINOX_PROFILE_WAIT_FOR_RESPONSE);
     return LUMINOX_SUCCESS;
 }
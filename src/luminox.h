@@ -15,6 +15,7 @@
 #define LUMINOX_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 //#define DEBUG_OUTPUT // comment this line out to turn off debug output
 #ifdef DEBUG_OUTPUT
@@ -23,12 +24,51 @@
 #include "nrf_log_default_backends.h"
 #endif
 
+//#define LUMINOX_NO_BAROMETRIC // uncomment this line for sensors without barometric pressure sensor to drop the pressure decoder
+//#define LUMINOX_PROFILING // uncomment this line to count cycles spent in every driver entry point
+//#define LUMINOX_ROLLUPS // uncomment this line to keep per minute and per hour min/max/mean of every measurement
+//#define LUMINOX_HISTORY // uncomment this line to keep the last LUMINOX_HISTORY_SIZE decoded samples in every handler
+
+/*
+    Every table the driver uses is a fixed size array inside its struct, nothing is ever allocated.
+    The sizes below can be overridden from the build (e.g. -DLUMINOX_MAX_SUBSCRIBERS=8) to size
+    the pools for the application.
+*/
+
 /* 
     Size of the uart receive and transmit buffer in bytes
     Use these to configure your UART protocol
 */
+#ifndef UART_TX_BUF_SIZE
 #define UART_TX_BUF_SIZE 128
+#endif
+#ifndef UART_RX_BUF_SIZE
 #define UART_RX_BUF_SIZE 128
+#endif
+#if UART_RX_BUF_SIZE > 255 || UART_RX_BUF_SIZE < 1
+#error "UART_RX_BUF_SIZE must fit in the uint8_t luminox_data_size"
+#endif
+
+/*
+    UART settings of the sensor, 9600 baud with 8 data bits, 1 start bit and 1 stop bit.
+    Used to turn byte counts into time the line was busy.
+*/
+#define LUMINOX_BAUDRATE 9600
+#define LUMINOX_BITS_PER_BYTE 10
+
+/*
+    Bus utilisation is measured over a sliding window of LUMINOX_BUS_WINDOW_SLOTS slots
+    of LUMINOX_BUS_SLOT_MS each, 10 seconds by default. Requires luminox_get_time.
+*/
+#ifndef LUMINOX_BUS_WINDOW_SLOTS
+#define LUMINOX_BUS_WINDOW_SLOTS 10
+#endif
+#if LUMINOX_BUS_WINDOW_SLOTS > 255 || LUMINOX_BUS_WINDOW_SLOTS < 1
+#error "LUMINOX_BUS_WINDOW_SLOTS must be 1 to 255"
+#endif
+#ifndef LUMINOX_BUS_SLOT_MS
+#define LUMINOX_BUS_SLOT_MS 1000
+#endif
 
 /*
     Set to the largest value that a 32 bit integer can represent, 
@@ -38,6 +78,14 @@
 */
 #define RESPONSE_TIMEOUT 0x989680
 
+/*
+    Time a non-blocking request sequence waits for each response before giving up, in milliseconds.
+    Needs luminox_get_time, without a time source sequences never time out.
+*/
+#ifndef LUMINOX_SEQUENCE_TIMEOUT_MS
+#define LUMINOX_SEQUENCE_TIMEOUT_MS 1000
+#endif
+
 // ascii codes for commands/keywords
 #define MODE_OUTPUT 0x4D // M
 #define PPO2 0x4F // O
@@ -50,6 +98,15 @@
 #define SEPARATOR 0x20 // " "
 #define TERMINATOR 0x0A // "\n"
 #define ERROR_RESPONSE 0x45 // E
+#define ERROR_RESPONSE_MIN_LEN 5 // "E 0x\r", the error code is the 4th byte
+
+// width in bytes of the argument of each measurement in a response
+#define PPO2_WIDTH 6 // xxxx.x
+#define O2_WIDTH 6 // xxx.xx
+#define TEMPERATURE_WIDTH 5 // yxx.x
+#define BAROMETRIC_PRESSURE_WIDTH 4 // xxxx
+#define SENSOR_STATUS_WIDTH 4 // xxxx
+#define BAROMETRIC_PRESSURE_MISSING_WIDTH 6 // ------, sent by sensors without barometric pressure sensor
 
 // @brief luminox output modes
 typedef enum {
@@ -59,6 +116,16 @@ typedef enum {
     LUMINOX_MODE_DEFAULT = LUMINOX_MODE_OFF // default mode is off
 } luminox_mode_t;
 
+// @brief luminox measurement requests, see luminox_request()
+typedef enum {
+    LUMINOX_COMMAND_ALL = 0, // luminox_request_all()
+    LUMINOX_COMMAND_PPO2, // luminox_request_ppO2()
+    LUMINOX_COMMAND_O2, // luminox_request_O2()
+    LUMINOX_COMMAND_TEMP, // luminox_request_temp()
+    LUMINOX_COMMAND_BAROMETRIC_PRESSURE, // luminox_request_barometric_pressure()
+    LUMINOX_COMMAND_SENSOR_STATUS // luminox_request_sensor_status()
+} luminox_command_t;
+
 // @brief luminox sensor information
 typedef enum {
     LUMINOX_INFO_DATE_OF_MFG = 0, // date of manufacturing
@@ -66,6 +133,83 @@ typedef enum {
     LUMINOX_INFO_SW_VER // software revision
 } luminox_sensor_info_t;
 
+// @brief requests of a non-blocking request sequence, see luminox_probe_start()
+typedef enum {
+    LUMINOX_STEP_END = 0, // terminates a sequence
+    LUMINOX_STEP_MODE_POLLING, // "M 1"
+    LUMINOX_STEP_MODE_DEFAULT, // "M x" with LUMINOX_MODE_DEFAULT
+    LUMINOX_STEP_DATE_OF_MFG, // "# 0"
+    LUMINOX_STEP_SERIAL_NUM, // "# 1"
+    LUMINOX_STEP_SW_VER, // "# 2"
+    LUMINOX_STEP_SENSOR_STATUS, // "e"
+    LUMINOX_STEP_ALL, // "A"
+    LUMINOX_STEP_BAROMETRIC_PRESSURE // "P"
+} luminox_step_t;
+
+/*
+    Size of each sensor information string including the terminating 0,
+    the longest is "YYYYY DDDDD" for the date of manufacture
+*/
+#define LUMINOX_INFO_SIZE 12
+
+// @brief luminox sensor identity, decoded from the "#" responses
+typedef struct {
+    char date_of_mfg[LUMINOX_INFO_SIZE];
+    char serial_number[LUMINOX_INFO_SIZE];
+    char sw_version[LUMINOX_INFO_SIZE];
+} luminox_identity_t;
+
+/*
+    Number of calibration table entries per handler, the table is statically allocated in luminox_handler_t.
+    Each entry is stored in LUMINOX_CALIBRATION_BLOB_ENTRY_SIZE bytes in a calibration blob.
+*/
+#ifndef LUMINOX_MAX_CALIBRATIONS
+#define LUMINOX_MAX_CALIBRATIONS 4
+#endif
+#if LUMINOX_MAX_CALIBRATIONS > 255 || LUMINOX_MAX_CALIBRATIONS < 1
+#error "LUMINOX_MAX_CALIBRATIONS must be 1 to 255"
+#endif
+#define LUMINOX_CALIBRATION_FIELDS 4 // ppO2, O2, temperature and barometric pressure, in luminox_field_t bit order
+#define LUMINOX_CALIBRATION_BLOB_VERSION 1
+#define LUMINOX_CALIBRATION_BLOB_HEADER_SIZE 2 // version, entry count
+#define LUMINOX_CALIBRATION_BLOB_ENTRY_SIZE (LUMINOX_INFO_SIZE + LUMINOX_CALIBRATION_FIELDS * 8)
+
+/*
+    Bench calibration of one sensor. Corrected value = raw * gain + offset, applied in fixed point
+    while decoding, so raw values are never visible to the rest of the driver.
+*/
+typedef struct {
+    char serial_number[LUMINOX_INFO_SIZE]; // serial number as decoded into luminox_identity_t
+    int32_t offset[LUMINOX_CALIBRATION_FIELDS]; // in hundredths of the unit of the field
+    int32_t gain[LUMINOX_CALIBRATION_FIELDS]; // Q16.16, 65536 is a gain of 1
+} luminox_calibration_t;
+
+/*
+    Number of points in the temperature compensation curve of each handler
+*/
+#ifndef LUMINOX_MAX_COMPENSATION_POINTS
+#define LUMINOX_MAX_COMPENSATION_POINTS 8
+#endif
+#if LUMINOX_MAX_COMPENSATION_POINTS > 255 || LUMINOX_MAX_COMPENSATION_POINTS < 1
+#error "LUMINOX_MAX_COMPENSATION_POINTS must be 1 to 255"
+#endif
+
+/*
+    Point of the temperature compensation curve. Between points the gain is interpolated linearly,
+    below the first and above the last point their gain is used.
+*/
+typedef struct {
+    int32_t temp; // sensor temperature in hundredths of a degree C, points in ascending order
+    int32_t gain; // Q16.16 applied to ppO2 and O2 at that temperature, 65536 is a gain of 1
+} luminox_compensation_point_t;
+
+// @brief luminox sensor variants
+typedef enum {
+    LUMINOX_VARIANT_UNKNOWN = 0, // not detected yet
+    LUMINOX_VARIANT_BAROMETRIC, // fitted with barometric pressure sensor
+    LUMINOX_VARIANT_NO_BAROMETRIC // no barometric pressure sensor, pressure is always "------"
+} luminox_variant_t;
+
 // @brief luminox return codes
 typedef enum {
     /*
@@ -116,19 +260,387 @@ typedef enum {
     */
     LUMINOX_ERR_TIMEOUT,
     LUMINOX_ERROR, // generic error code
-    LUMINOX_SUCCESS // message sent or response received successfully
+    LUMINOX_SUCCESS, // message sent or response received successfully
+    // codes added later, after LUMINOX_SUCCESS so the values above keep their numbers
+    /*
+	Error: Table Full
+	Cause: a statically sized table in luminox_handler_t has no free entries
+	Action:	- Remove an unused entry first
+		- Increase the matching LUMINOX_MAX_x define
+    */
+    LUMINOX_ERR_FULL,
+    /*
+	Error: No Barometric Pressure
+	Cause: a value derived from barometric pressure was requested but the sensor answered "------"
+	       and no external pressure was set
+	Action:	- Call luminox_set_external_pressure() with a pressure from another source
+    */
+    LUMINOX_ERR_NO_PRESSURE,
+    /*
+	Error: No Data
+	Cause: a value derived from a measurement was requested before the sensor reported it,
+	       or the newest response reported it as unavailable ("------")
+	Action:	- Request the measurement first
+		- Check the sensor status
+    */
+    LUMINOX_ERR_NO_DATA
 } luminox_retcode_t;
 
+// @brief luminox measurement fields, combine as a bit mask
+typedef enum {
+    LUMINOX_FIELD_PPO2 = 0x01, // ppO2 in mbar
+    LUMINOX_FIELD_O2 = 0x02, // O2 in percent %
+    LUMINOX_FIELD_TEMP = 0x04, // temperature in °C
+    LUMINOX_FIELD_BAROMETRIC_PRESSURE = 0x08, // barometric pressure in mbar
+    LUMINOX_FIELD_STATUS = 0x10, // sensor status
+    LUMINOX_FIELD_ALL = 0x1F, // every field
+    LUMINOX_FIELD_EXCEPTIONS_ONLY = 0x80 // not a field, subscriber is only called for fields that moved past their deadband
+} luminox_field_t;
+
+// number of measurement fields, bit n of a luminox_field_t mask is field n
+#define LUMINOX_FIELD_COUNT 5
+#define LUMINOX_FLOAT_FIELD_COUNT 4 // ppO2, O2, temperature and barometric pressure are fields 0 to 3
+
+// @brief most recent measurements decoded from the sensor
+typedef struct {
+    float ppo2;
+    float o2;
+    float temp;
+    float barometric_pressure;
+    uint16_t status;
+    float ppo2_raw; // ppO2 before temperature compensation
+    float o2_raw; // O2 before temperature compensation
+    uint8_t fields; // luminox_field_t mask of the values updated by the last response
+    uint8_t exceptions; // luminox_field_t mask of the updated values that moved past their deadband
+    uint8_t missing; // luminox_field_t mask of the values the sensor reported as unavailable ("------")
+    uint8_t suppressed; // luminox_field_t mask of the values held back as possible spikes, not in fields
+    uint8_t steps; // luminox_field_t mask of the updated values that confirmed a step change
+    uint8_t possible_steps; // luminox_field_t mask of the held back values that may start a step, see luminox_set_spike_filter()
+    uint32_t sequence; // incremented for every decoded response
+    uint32_t timestamp; // time the sensor started sending the response in milliseconds, 0 without a time source
+} luminox_sample_t;
+
+/*
+    Number of subscribers that can be registered on one handler.
+    The subscriber table is statically allocated inside luminox_handler_t.
+*/
+#ifndef LUMINOX_MAX_SUBSCRIBERS
+#define LUMINOX_MAX_SUBSCRIBERS 4
+#endif
+#if LUMINOX_MAX_SUBSCRIBERS > 255 || LUMINOX_MAX_SUBSCRIBERS < 1
+#error "LUMINOX_MAX_SUBSCRIBERS must be 1 to 255"
+#endif
+
+/*
+    Subscriber callback, called from luminox_process_response() with a pointer to the
+    handler's sample. The sample is not copied, so it is only valid during the call.
+*/
+typedef void (*luminox_subscriber_cb_t)(const luminox_sample_t * sample, void * context);
+
+// @brief luminox subscriber table entry
+typedef struct {
+    luminox_subscriber_cb_t callback;
+    void * context; // passed back to the callback untouched
+    uint8_t field_mask; // luminox_field_t mask, callback only runs when one of these fields is updated
+} luminox_subscriber_t;
+
+// @brief direction of a captured UART transfer
+typedef enum {
+    LUMINOX_CAPTURE_TX = 0, // request sent to the sensor
+    LUMINOX_CAPTURE_RX // response received from the sensor
+} luminox_capture_dir_t;
+
+/*
+    Captured UART transfer, handed to the capture callback and consumed by luminox_replay().
+    When passed to the capture callback data points into the driver and is only valid during the call,
+    copy the bytes out to keep them.
+*/
+typedef struct {
+    uint32_t timestamp; // milliseconds, from luminox_get_time
+    luminox_capture_dir_t direction;
+    uint8_t size; // number of bytes in data
+    const uint8_t * data;
+} luminox_capture_record_t;
+
+#ifdef LUMINOX_PROFILING
+// @brief driver entry points timed when LUMINOX_PROFILING is defined
+typedef enum {
+    LUMINOX_PROFILE_SET_OUTPUT_MODE = 0, // luminox_set_ouput_mode()
+    LUMINOX_PROFILE_REQUEST_PPO2, // luminox_request_ppO2()
+    LUMINOX_PROFILE_REQUEST_O2, // luminox_request_O2()
+    LUMINOX_PROFILE_REQUEST_TEMP, // luminox_request_temp()
+    LUMINOX_PROFILE_REQUEST_BAROMETRIC_PRESSURE, // luminox_request_barometric_pressure()
+    LUMINOX_PROFILE_REQUEST_SENSOR_STATUS, // luminox_request_sensor_status()
+    LUMINOX_PROFILE_REQUEST_ALL, // luminox_request_all()
+    LUMINOX_PROFILE_REQUEST_SENSOR_INFO, // luminox_request_sensor_info()
+    LUMINOX_PROFILE_PROCESS_RESPONSE, // luminox_process_response()
+    LUMINOX_PROFILE_ERROR_HANDLER, // luminox_error_handler()
+    LUMINOX_PROFILE_WAIT_FOR_RESPONSE, // luminox_wait_for_response()
+    LUMINOX_PROFILE_COUNT // number of timed entry points
+} luminox_profile_id_t;
+
+/*
+    Cycles spent in one driver entry point, the average is total / count.
+    Times are inclusive, so a request also contains the luminox_process_response() it calls.
+*/
+typedef struct {
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t count;
+} luminox_profile_stat_t;
+#endif
+
+/*
+    Trace events, passed to the luminox_trace callback as they happen. Each pair of events opens and closes
+    a span, use luminox_trace_event_name() and luminox_trace_event_phase() to turn them into Chrome trace events.
+*/
+typedef enum {
+    LUMINOX_TRACE_TX_START = 0, // request handed to luminox_tx
+    LUMINOX_TRACE_TX_END, // luminox_tx returned
+    LUMINOX_TRACE_RX_FIRST_BYTE, // first byte of a response received
+    LUMINOX_TRACE_RX_TERMINATOR, // terminator of a response received
+    LUMINOX_TRACE_PARSE_START, // luminox_process_response() started decoding
+    LUMINOX_TRACE_PARSE_END, // decoding finished
+    LUMINOX_TRACE_DISPATCH_START, // calling the subscribers
+    LUMINOX_TRACE_DISPATCH_END // all subscribers returned
+} luminox_trace_event_t;
+
+// @brief bytes transferred during one slot of the bus utilisation window
+typedef struct {
+    uint32_t tx_bytes; // 32 bit, a uint16_t wraps after about 68 s of a busy line at LUMINOX_BAUDRATE
+    uint32_t rx_bytes;
+} luminox_bus_slot_t;
+
+// @brief UART traffic of one sensor, filled in by luminox_get_bus_stats()
+typedef struct {
+    uint32_t tx_bytes_total; // bytes sent since luminox_init()
+    uint32_t rx_bytes_total; // bytes received since luminox_init()
+    uint32_t tx_bytes; // bytes sent during the window
+    uint32_t rx_bytes; // bytes received during the window
+    uint32_t window_ms; // length of the window the figures below cover
+    float tx_utilisation; // percentage of the window the TX line was busy
+    float rx_utilisation; // percentage of the window the RX line was busy
+    uint32_t headroom; // bytes per second still free on the busier direction
+} luminox_bus_stats_t;
+
+/*
+    Batch callback, called with the samples collected in the caller supplied batch buffer.
+    The samples are contiguous, so the whole batch can be written out with a single write() or memcpy().
+*/
+typedef void (*luminox_batch_cb_t)(const luminox_sample_t * samples, uint16_t count, void * context);
+
+/*
+    Deadband of one field for report by exception. A value is an exception when it differs from the last
+    reported value by more than both the absolute and the relative threshold, or when max_silence_ms
+    passed since the last report.
+*/
+typedef struct {
+    float absolute; // in the unit of the field
+    float relative; // fraction of the last reported value, 0.01 is 1 %
+    uint32_t max_silence_ms; // heartbeat, 0 to disable
+    float last_value; // last reported value
+    uint32_t last_time; // time of the last report
+    bool reported; // last_value holds a value
+} luminox_deadband_t;
+
+/*
+    Number of fields whose quantiles each handler can track at once, e.g. 2 for O2 and ppO2
+*/
+#ifndef LUMINOX_MAX_QUANTILES
+#define LUMINOX_MAX_QUANTILES 2
+#endif
+#if LUMINOX_MAX_QUANTILES > 4 || LUMINOX_MAX_QUANTILES < 1
+#error "LUMINOX_MAX_QUANTILES must be 1 to 4, one per float field"
+#endif
+
+/*
+    Bins of each quantile histogram, 4 bytes each. More bins stay one reading step wide over a wider span of values.
+*/
+#ifndef LUMINOX_QUANTILE_BINS
+#define LUMINOX_QUANTILE_BINS 32
+#endif
+#if LUMINOX_QUANTILE_BINS > 1024 || LUMINOX_QUANTILE_BINS < 4
+#error "LUMINOX_QUANTILE_BINS must be 4 to 1024"
+#endif
+
+/*
+    Histogram of the values of one field since the last reset, on the field's reading resolution
+    (ppO2 0.1 mbar, O2 0.01 %, temperature 0.1 C, barometric pressure 1 mbar).
+    Bins start one reading step wide and double in width whenever the values outgrow them, so memory stays fixed
+    and every quantile of the field can be read from the same bins.
+*/
+typedef struct {
+    uint8_t field; // single float luminox_field_t
+    uint8_t shift; // every bin spans 2^shift reading steps
+    uint32_t count; // number of values seen since the last reset
+    int32_t first; // reading step of the start of bins[0], divided by 2^shift
+    uint32_t bins[LUMINOX_QUANTILE_BINS]; // number of values per bin
+} luminox_quantile_t;
+
+/*
+    Spike and step detector of one field. A value further than threshold from the last accepted value is held back.
+    If the field returns within threshold of the accepted value before window values have passed, the held values
+    were a spike and are dropped. If window values in a row stay within threshold of the first one, the field
+    stepped to a new level and the last one is reported with its bit set in the sample's steps mask. The first held
+    back value at a new level sets its bit in the sample's possible_steps mask right away.
+*/
+typedef struct {
+    float threshold; // jump that is held back, 0 if the detector is off
+    uint8_t window; // values in a row at a new level that confirm a step, 1 reports every jump as a step
+    uint8_t held; // values held back at the candidate level
+    bool accepted; // reference holds a value
+    float reference; // last accepted value
+    float reference_raw; // sample.ppo2_raw or sample.o2_raw of the last accepted value, the value itself for other fields
+    float candidate; // first held back value
+    uint32_t spikes; // spikes dropped since luminox_init()
+    uint32_t steps; // steps confirmed since luminox_init()
+} luminox_spike_filter_t;
+
+#ifdef LUMINOX_HISTORY
+/*
+    Number of decoded samples kept in the history ring of each handler, one minute at 1 Hz by default
+*/
+#ifndef LUMINOX_HISTORY_SIZE
+#define LUMINOX_HISTORY_SIZE 60
+#endif
+#if LUMINOX_HISTORY_SIZE > 65535 || LUMINOX_HISTORY_SIZE < 1
+#error "LUMINOX_HISTORY_SIZE must be 1 to 65535"
+#endif
+
+/*
+    History ring of decoded samples, stored as one contiguous array per field so a column can be handed
+    to analysis code (e.g. as a NumPy array through the buffer protocol) without copying.
+    Use luminox_history_segments() to find the oldest to newest order inside the arrays.
+*/
+typedef struct {
+    float ppo2[LUMINOX_HISTORY_SIZE];
+    float o2[LUMINOX_HISTORY_SIZE];
+    float temp[LUMINOX_HISTORY_SIZE];
+    float barometric_pressure[LUMINOX_HISTORY_SIZE];
+    uint16_t status[LUMINOX_HISTORY_SIZE];
+    uint32_t timestamp[LUMINOX_HISTORY_SIZE];
+    uint8_t fields[LUMINOX_HISTORY_SIZE]; // luminox_field_t mask of the values the response updated
+    uint16_t head; // index the next sample is written to
+    uint16_t count; // number of samples stored, at most LUMINOX_HISTORY_SIZE
+} luminox_history_t;
+
+// @brief contiguous run of history samples, indices into every column of luminox_history_t
+typedef struct {
+    uint16_t start;
+    uint16_t count;
+} luminox_history_segment_t;
+#endif
+
+#ifdef LUMINOX_ROLLUPS
+/*
+    Number of buckets kept by each rollup tier. The defaults cover the last hour by minute and the last day by hour,
+    about 5 kB per handler.
+*/
+#ifndef LUMINOX_ROLLUP_MINUTES
+#define LUMINOX_ROLLUP_MINUTES 60
+#endif
+#ifndef LUMINOX_ROLLUP_HOURS
+#define LUMINOX_ROLLUP_HOURS 24
+#endif
+#if LUMINOX_ROLLUP_MINUTES > 65535 || LUMINOX_ROLLUP_MINUTES < 1 || LUMINOX_ROLLUP_HOURS > 65535 || LUMINOX_ROLLUP_HOURS < 1
+#error "LUMINOX_ROLLUP_MINUTES and LUMINOX_ROLLUP_HOURS must be 1 to 65535"
+#endif
+#define LUMINOX_ROLLUP_FIELDS 4 // ppO2, O2, temperature and barometric pressure, indexed by field bit
+
+// @brief rollup tiers, each is a ring of buckets of a fixed period
+typedef enum {
+    LUMINOX_ROLLUP_MINUTE = 0,
+    LUMINOX_ROLLUP_HOUR,
+    LUMINOX_ROLLUP_TIER_COUNT
+} luminox_rollup_tier_t;
+
+// @brief summary of one measurement over a bucket, the mean is sum / count
+typedef struct {
+    float min;
+    float max;
+    float sum;
+    uint32_t count; // number of values, 0 if the field wasn't reported during the bucket
+} luminox_rollup_stat_t;
+
+// @brief one period of a rollup tier
+typedef struct {
+    uint32_t start; // start of the period in milliseconds, a multiple of the tier's period
+    luminox_rollup_stat_t stat[LUMINOX_ROLLUP_FIELDS];
+} luminox_rollup_bucket_t;
+#endif
+
 // luminox driver handler struct
 typedef struct {
     luminox_mode_t current_mode;
-    float current_ppO2;
-    float current_O2;
-    float current_temp;
-    float current_barometric_pressure;
+    luminox_sample_t sample;
     uint8_t luminox_data[UART_RX_BUF_SIZE];
+    uint8_t luminox_data_size; // number of valid bytes in luminox_data
+    uint8_t rx_buffer[UART_RX_BUF_SIZE]; // response being received by luminox_receive_byte()
+    uint8_t rx_index; // number of bytes in rx_buffer
+    uint32_t rx_first_byte_time; // time the first byte in rx_buffer arrived
+    uint32_t rx_frame_time; // time the sensor started sending the response in luminox_data
     luminox_retcode_t err_code;
+    luminox_subscriber_t subscribers[LUMINOX_MAX_SUBSCRIBERS];
+    uint8_t subscriber_count;
+    luminox_deadband_t deadband[LUMINOX_FIELD_COUNT]; // indexed by field bit
+    luminox_quantile_t quantiles[LUMINOX_MAX_QUANTILES];
+    luminox_spike_filter_t spike_filter[LUMINOX_FLOAT_FIELD_COUNT]; // indexed by field bit
+    uint8_t quantile_count;
+    luminox_identity_t identity;
+    luminox_sensor_info_t pending_info; // information requested by the last luminox_request_sensor_info()
+    luminox_calibration_t calibration[LUMINOX_MAX_CALIBRATIONS];
+    uint8_t calibration_count;
+    const luminox_calibration_t * active_calibration; // entry matching identity.serial_number, NULL if none
+    luminox_compensation_point_t compensation[LUMINOX_MAX_COMPENSATION_POINTS];
+    uint8_t compensation_count; // 0 if temperature compensation is off
+    int32_t temp_hundredths; // last decoded temperature in hundredths of a degree C
+    bool temp_known; // temp_hundredths holds a value
+#ifdef LUMINOX_HISTORY
+    luminox_history_t history;
+#endif
+#ifdef LUMINOX_ROLLUPS
+    luminox_rollup_bucket_t rollup[LUMINOX_ROLLUP_MINUTES + LUMINOX_ROLLUP_HOURS]; // minute ring followed by hour ring
+    uint16_t rollup_head[LUMINOX_ROLLUP_TIER_COUNT]; // index of the current bucket in each ring
+    uint16_t rollup_count[LUMINOX_ROLLUP_TIER_COUNT]; // number of buckets used in each ring
+#endif
+    luminox_variant_t variant; // detected by luminox_init(), a later pressure value switches it back to LUMINOX_VARIANT_BAROMETRIC
+    bool barometric_pressure_valid; // the last barometric pressure response held a value
+    float external_pressure; // mbar, from luminox_set_external_pressure(), 0 if not set
+    float derived_O2; // cached result of luminox_get_derived_O2()
+    bool derived_valid; // derived_O2 holds a value
+    uint8_t fields_seen; // luminox_field_t mask of the values decoded at least once since luminox_init()
+    uint32_t derived_sequence; // sample.sequence derived_O2 was computed for
+    luminox_sample_t * batch; // caller supplied batch buffer, NULL if batching is off
+    uint16_t batch_capacity; // number of samples the batch buffer holds
+    uint16_t batch_count; // number of samples in the batch buffer
+    uint32_t batch_deadline_ms; // deliver a batch this long after its first sample, 0 to only deliver full batches
+    uint32_t batch_start; // time the first sample of the batch was added
+    luminox_batch_cb_t batch_callback;
+    void * batch_context; // passed back to batch_callback untouched
+    uint32_t request_time; // time the last request was sent
+    uint32_t response_latency; // time between the last request and its response
+    bool request_pending; // a request was sent and its response has not been processed yet
+    const luminox_step_t * sequence; // non-blocking request sequence being run, NULL if none
+    uint8_t sequence_step; // index of the step waiting for its response
+    luminox_retcode_t sequence_result; // outcome of the last sequence, LUMINOX_ERROR while one runs
+    bool replay_active; // luminox_replay() or a sniffer is running, time comes from virtual_time
+    uint32_t virtual_time; // replay clock, timestamp of the record being replayed
+    luminox_bus_slot_t bus_slots[LUMINOX_BUS_WINDOW_SLOTS]; // ring of bus utilisation slots
+    uint32_t bus_slot; // number of the current slot, time / LUMINOX_BUS_SLOT_MS
+    uint8_t bus_slots_used; // completed slots in the window before the current one
+    uint32_t tx_bytes_total;
+    uint32_t rx_bytes_total;
     void (*luminox_tx)(unsigned char *request, uint8_t size); // must be initialized
+    uint32_t (*luminox_get_time)(void); // optional, millisecond time source, NULL if unused
+    void (*luminox_capture)(const luminox_capture_record_t * record, void * context); // optional, NULL if unused
+    void * capture_context; // passed back to luminox_capture untouched
+    void (*luminox_trace)(luminox_trace_event_t event, void * context); // optional, timestamp events here, NULL if unused
+    void * trace_context; // passed back to luminox_trace untouched
+#ifdef LUMINOX_PROFILING
+    uint32_t (*luminox_get_cycles)(void); // free running cycle counter, e.g. DWT->CYCCNT or rdtsc, must be initialized
+    luminox_profile_stat_t profile[LUMINOX_PROFILE_COUNT];
+#endif
 } luminox_handler_t;
 
 /*******************************[ High-Level Sensor Functions For General Use ]****************************************/
@@ -163,7 +675,7 @@ luminox_retcode_t luminox_request_ppO2(luminox_handler_t * luminox_handler);
 /*
     @brief Function for getting the current ppO2 value
 
-    @note This function returns whatever is stored in the current_ppO2 variable, which may be out of date. Call luminox_request_ppO2() first.
+    @note This function returns whatever is stored in the sample.ppo2 variable, which may be out of date. Call luminox_request_ppO2() first.
 
     @return Floating point integer of the ppO2 value
 */
@@ -181,7 +693,7 @@ luminox_retcode_t luminox_request_O2(luminox_handler_t * luminox_handler);
 /*
     @brief Function for getting the current O2 value
 
-    @note This function returns whatever is stored in the current_O2 variable, which may be out of date. Call luminox_request_O2() first.
+    @note This function returns whatever is stored in the sample.o2 variable, which may be out of date. Call luminox_request_O2() first.
 
     @return Floating point integer of the O2 value
 */
@@ -199,7 +711,7 @@ luminox_retcode_t luminox_request_temp(luminox_handler_t * luminox_handler);
 /*
     @brief Function for getting the current temp value
 
-    @note This function returns whatever is stored in the current_temp variable, which may be out of date. Call luminox_request_temp() first.
+    @note This function returns whatever is stored in the sample.temp variable, which may be out of date. Call luminox_request_temp() first.
 
     @return Floating point integer of the temp value
 */
@@ -219,12 +731,54 @@ luminox_retcode_t luminox_request_barometric_pressure(luminox_handler_t * lumino
 /*
     @brief Function for getting the current barometric pressure value
 
-    @note This function returns whatever is stored in the current_barometric_pressure variable, which may be out of date. Call luminox_request_barometric_pressure() first.
+    @note This function returns whatever is stored in the sample.barometric_pressure variable, which may be out of date. Call luminox_request_barometric_pressure() first.
+	  If the sensor answered "------" the previous value is kept, check luminox_barometric_pressure_valid().
 
     @return Floating point integer of the barometric pressure value
 */
 float luminox_get_barometric_pressure(luminox_handler_t * luminox_handler);
 
+/*
+    @brief Function for checking if the sensor reported a barometric pressure
+
+    @note Sensors without a barometric pressure sensor answer "------", which leaves this false
+
+    @return true if the last barometric pressure response held a value
+*/
+bool luminox_barometric_pressure_valid(luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for getting the variant of the sensor detected by luminox_init()
+
+    @return luminox_variant_t with or without barometric pressure sensor
+*/
+luminox_variant_t luminox_get_variant(luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for setting a barometric pressure measured outside the sensor
+
+    @note Used by luminox_get_derived_O2() when the sensor has no barometric pressure sensor
+
+    @param[in] pressure Barometric pressure in mbar, 0 or less to clear it
+*/
+void luminox_set_external_pressure(float pressure, luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for getting the O2 percentage computed from ppO2 and barometric pressure
+
+    @note Uses the sensor's barometric pressure when it reports one, otherwise the pressure given to
+	  luminox_set_external_pressure(). Computed at most once per decoded response and cached.
+
+    @note Fails rather than reporting 0 % until a ppO2 value has been decoded, and while the newest response
+	  reported ppO2 as unavailable.
+
+    @param[out] o2 O2 in percent %, only written on success
+
+    @return luminox_retcode_t Either success, LUMINOX_ERR_NO_DATA without a ppO2 value
+			      or LUMINOX_ERR_NO_PRESSURE if no pressure is available
+*/
+luminox_retcode_t luminox_get_derived_O2(float * o2, luminox_handler_t * luminox_handler);
+
 /*
     @brief Function for requesting the current sensor status
 
@@ -235,6 +789,15 @@ float luminox_get_barometric_pressure(luminox_handler_t * luminox_handler);
 */
 luminox_retcode_t luminox_request_sensor_status(luminox_handler_t * luminox_handler);
 
+/*
+    @brief Function for getting the current sensor status
+
+    @note This function returns whatever is stored in the sample.status variable, which may be out of date. Call luminox_request_sensor_status() first.
+
+    @return Sensor status, 0 means the sensor status is good
+*/
+uint16_t luminox_get_sensor_status(luminox_handler_t * luminox_handler);
+
 /*
     @brief Function for requesting ppO2, O2, temperature, barometric pressure, and sensor status
 
@@ -244,6 +807,15 @@ luminox_retcode_t luminox_request_sensor_status(luminox_handler_t * luminox_hand
 */
 luminox_retcode_t luminox_request_all(luminox_handler_t * luminox_handler);
 
+/*
+    @brief Function for sending one of the measurement requests
+
+    @param[in] command Measurement to request
+
+    @return luminox_retcode_t Either success, one of the error codes or LUMINOX_ERROR for an invalid command
+*/
+luminox_retcode_t luminox_request(luminox_command_t command, luminox_handler_t * luminox_handler);
+
 /*
     @brief Function for requesting the given sensor information
 
@@ -257,11 +829,365 @@ luminox_retcode_t luminox_request_all(luminox_handler_t * luminox_handler);
 */
 luminox_retcode_t luminox_request_sensor_info(luminox_sensor_info_t info, luminox_handler_t * luminox_handler);
 
+/*
+    @brief Function for starting a non-blocking probe of the device on the UART
+
+    @note Sends the polling mode request, then the serial number, status and all measurements requests one at a time,
+	  each after luminox_process_response() handled the response of the one before. Feed the received bytes with
+	  luminox_receive_byte() and call luminox_process_response() for every complete response as usual, so many
+	  ports can be probed at once from one loop. Responses that don't answer the current request are ignored.
+
+    @note luminox_tx must not block. It is called from inside luminox_process_response() for every request after the
+	  first, so a luminox_tx that waits for the response (like the blocking uart_write() in the README) stalls
+	  the loop and probes the ports one after another. Copy the request, which is only valid during the call,
+	  into the port's TX buffer, start the transfer and return, e.g.
+	      void uart_write_async(unsigned char * tx, uint8_t size) {
+	          memcpy(port_tx_buf, tx, size);
+	          uart_tx_start(port_tx_buf, size); // interrupt or DMA driven, returns at once
+	      }
+
+    @note The device is a LuminOx sensor if luminox_sequence_result() is LUMINOX_SUCCESS once luminox_sequence_busy()
+	  returns false, the identity, status and measurements are then in the handler.
+
+    @return luminox_retcode_t Either success or LUMINOX_ERROR if a sequence is already running
+*/
+luminox_retcode_t luminox_probe_start(luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for checking whether a non-blocking request sequence is still running
+
+    @note Also ends the sequence with LUMINOX_ERR_TIMEOUT when a response takes longer than LUMINOX_SEQUENCE_TIMEOUT_MS,
+	  call it from the loop that feeds the responses
+
+    @return true while the sequence waits for a response
+*/
+bool luminox_sequence_busy(luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for getting the outcome of the last non-blocking request sequence
+
+    @return luminox_retcode_t Success, the error of the request that failed, LUMINOX_ERR_TIMEOUT,
+			      or LUMINOX_ERROR while the sequence is running
+*/
+luminox_retcode_t luminox_sequence_result(luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for getting the time between the last request and its response
+
+    @note Requires luminox_get_time to be initialized, otherwise always 0
+
+    @return Latency of the last request in milliseconds
+*/
+uint32_t luminox_get_response_latency(luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for getting the UART traffic and utilisation of the sensor
+
+    @note Utilisation is the share of the window the line spent transferring bytes at LUMINOX_BAUDRATE.
+	  TX and RX are reported separately because the UART is full duplex.
+
+    @param[out] stats Filled in with the totals and the figures for the sliding window
+
+    @return luminox_retcode_t Either success or LUMINOX_ERROR if there is no time source
+*/
+luminox_retcode_t luminox_get_bus_stats(luminox_bus_stats_t * stats, luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for replaying captured UART transfers through the driver
+
+    @note Time is taken from the record timestamps instead of luminox_get_time, so a capture replays as fast
+	  as the micro can decode it. RX records are decoded with luminox_process_response() exactly as
+	  they were live, TX records only advance the clock and start the latency measurement.
+	  The capture callback is not called while replaying.
+
+    @param[in] records Array of records, as recorded by the luminox_capture callback
+
+    @param[in] count Number of records in the array
+
+    @return luminox_retcode_t Success, or the first error code returned while decoding a response
+*/
+luminox_retcode_t luminox_replay(const luminox_capture_record_t * records, uint32_t count, luminox_handler_t * luminox_handler);
+
+#ifdef LUMINOX_PROFILING
+/*
+    @brief Function for getting the profile of a driver entry point
+
+    @param[in] id Entry point to get the profile of
+
+    @return Pointer to the min/max/total cycles and call count of the entry point, NULL for an invalid id
+*/
+const luminox_profile_stat_t * luminox_get_profile(luminox_profile_id_t id, luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for clearing the profiles of every driver entry point
+
+    @note luminox_init() also clears the profiles
+*/
+void luminox_reset_profile(luminox_handler_t * luminox_handler);
+#endif
+
+/*
+    @brief Function for subscribing to decoded measurements
+
+    @note The callback is called from luminox_process_response() whenever a response updates one of the fields
+	  in field_mask, or holds one back as a possible step (see luminox_set_spike_filter()). Register subscribers after luminox_init(), which clears the subscriber table.
+
+    @param[in] callback Function to call with a pointer to the decoded sample
+
+    @param[in] context Pointer passed back to the callback
+
+    @param[in] field_mask luminox_field_t mask of the fields the subscriber is interested in
+
+    @return luminox_retcode_t Either success or LUMINOX_ERR_FULL if all LUMINOX_MAX_SUBSCRIBERS entries are used
+*/
+luminox_retcode_t luminox_subscribe(luminox_subscriber_cb_t callback, void * context, uint8_t field_mask, luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for removing a subscriber registered with luminox_subscribe()
+
+    @param[in] callback Callback of the subscriber to remove
+
+    @param[in] context Context of the subscriber to remove
+
+    @return luminox_retcode_t Either success or LUMINOX_ERROR if no matching subscriber was found
+*/
+luminox_retcode_t luminox_unsubscribe(luminox_subscriber_cb_t callback, void * context, luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for collecting decoded samples into a batch buffer
+
+    @note Every sample decoded by luminox_process_response() is copied into buffer. The callback is called once the
+	  buffer holds capacity samples, or deadline_ms after the first sample of the batch, whichever comes first.
+	  Call luminox_poll_batch() from the super loop so the deadline is also met when no new samples arrive.
+	  luminox_init() turns batching off.
+
+    @param[in] buffer Caller owned array of capacity samples, NULL to turn batching off
+
+    @param[in] capacity Number of samples in buffer
+
+    @param[in] deadline_ms Maximum age of the first sample in a batch before delivery, 0 to only deliver full batches
+
+    @param[in] callback Function to call with each batch
+
+    @param[in] context Pointer passed back to the callback
+
+    @return luminox_retcode_t Either success or LUMINOX_ERROR if buffer is set without a capacity or callback
+*/
+luminox_retcode_t luminox_set_batch(luminox_sample_t * buffer, uint16_t capacity, uint32_t deadline_ms, luminox_batch_cb_t callback, void * context, luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for delivering the batch if its deadline has passed
+
+    @note Call this function in your super loop when batching is used
+*/
+void luminox_poll_batch(luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for delivering the samples in the batch buffer right away
+*/
+void luminox_flush_batch(luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for configuring the deadband of a field
+
+    @note Every field starts with no deadband after luminox_init(), so any change is an exception.
+	  Subscribers registered with LUMINOX_FIELD_EXCEPTIONS_ONLY in their mask are only called when one of
+	  their fields is in the sample's exceptions mask.
+
+    @param[in] field Single luminox_field_t to configure
+
+    @param[in] absolute Change in the unit of the field that is reported
+
+    @param[in] relative Change as a fraction of the last reported value that is reported
+
+    @param[in] max_silence_ms Report the field at least this often even if it doesn't change, 0 to disable
+
+    @return luminox_retcode_t Either success or LUMINOX_ERROR if field is not a single field
+*/
+luminox_retcode_t luminox_set_deadband(luminox_field_t field, float absolute, float relative, uint32_t max_silence_ms, luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for configuring the spike and step detector of a field
+
+    @note Runs on every decoded value before the deadband, history and subscribers, so a dropped spike never
+	  reaches them. A held back value is left out of the sample's fields and set in its suppressed mask, and the
+	  getters, sample.ppo2_raw and sample.o2_raw keep the last accepted value. The first value at a new level
+	  sets the field's bit in the sample's possible_steps mask and calls the field's subscribers, even though
+	  the value itself is held back, they find it in the candidate of luminox_get_spike_filter(). A step is confirmed in the steps mask window - 1 responses later, a spike
+	  never is.
+
+    @param[in] field Single float field: ppO2, O2, temperature or barometric pressure
+
+    @param[in] threshold Jump in the unit of the field that is held back, 0 to turn the detector off
+
+    @param[in] window Values in a row at a new level that confirm a step, at least 1
+
+    @return luminox_retcode_t Either success or LUMINOX_ERR_INVALID_ARG for an invalid field, threshold or window
+*/
+luminox_retcode_t luminox_set_spike_filter(luminox_field_t field, float threshold, uint8_t window, luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for getting the state and counters of the spike and step detector of a field
+
+    @param[in] field Single float field: ppO2, O2, temperature or barometric pressure
+
+    @return Pointer to the detector, NULL for an invalid field
+*/
+const luminox_spike_filter_t * luminox_get_spike_filter(luminox_field_t field, luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for starting to track the quantiles of a field
+
+    @note Every value decoded afterwards is counted in the field's histogram in constant memory. Once a field is
+	  tracked, any quantile of it can be read, not only p. The tracked fields are cleared by luminox_init(),
+	  so call it afterwards.
+
+    @param[in] field Single float field: ppO2, O2, temperature or barometric pressure
+
+    @param[in] p Quantile that will be read, e.g. 0.01 for p1 or 0.99 for p99
+
+    @return luminox_retcode_t Either success, LUMINOX_ERR_INVALID_ARG for an invalid field or p
+			      or LUMINOX_ERR_FULL if LUMINOX_MAX_QUANTILES other fields are tracked
+*/
+luminox_retcode_t luminox_track_quantile(luminox_field_t field, float p, luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for getting a quantile of a tracked field
+
+    @note Returns the middle of the histogram bin holding the nearest rank quantile (the value at rank ceil(p * count))
+	  of the values since the last reset, rounded to the field's reading resolution. It is never further than
+	  half a bin width from that quantile. Bins are one reading step wide, so the result is exact, until the values
+	  span LUMINOX_QUANTILE_BINS reading steps. Wider spans double the bin width only as often as needed, so a bin
+	  stays narrower than 2 * span / (LUMINOX_QUANTILE_BINS - 1) reading steps. The width in use is 2^shift steps
+	  of the field's luminox_quantile_t. A single outlier counts towards the span until the next reset.
+	  tools/luminox_quantile_check.c checks both bounds.
+
+    @param[in] field Field passed to luminox_track_quantile()
+
+    @param[in] p Quantile, 0 < p < 1
+
+    @param[out] value Quantile of the values since the last reset
+
+    @return luminox_retcode_t Either success, LUMINOX_ERR_INVALID_ARG if the field isn't tracked or p is invalid
+			      or LUMINOX_ERROR if no value was seen yet
+*/
+luminox_retcode_t luminox_get_quantile(luminox_field_t field, float p, float * value, luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for emptying the histogram of every tracked field, e.g. at the start of a shift
+*/
+void luminox_reset_quantiles(luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for getting the identity of the sensor
+
+    @note Filled in by the responses to luminox_request_sensor_info(), luminox_init() requests all of them
+
+    @return Pointer to the date of manufacture, serial number and software revision strings
+*/
+const luminox_identity_t * luminox_get_identity(luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for loading the calibration table from a blob
+
+    @note Replaces the whole table and selects the entry matching the serial number of the sensor.
+	  The blob starts with LUMINOX_CALIBRATION_BLOB_VERSION and the entry count, followed by one entry per
+	  LUMINOX_CALIBRATION_BLOB_ENTRY_SIZE bytes: the serial number, then the offset and gain of every
+	  field as little endian int32. luminox_init() clears the table, so load it afterwards.
+
+    @param[in] blob Calibration blob, as written by luminox_save_calibration()
+
+    @param[in] size Size of the blob in bytes
+
+    @return luminox_retcode_t Success, LUMINOX_ERR_FULL for more than LUMINOX_MAX_CALIBRATIONS entries or
+			      LUMINOX_ERROR for a malformed blob
+*/
+luminox_retcode_t luminox_load_calibration(const uint8_t * blob, uint16_t size, luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for saving the calibration table to a blob
+
+    @param[out] blob Buffer to write the blob to
+
+    @param[in] size Size of the buffer in bytes
+
+    @param[out] written Number of bytes written to blob
+
+    @return luminox_retcode_t Either success or LUMINOX_ERR_FULL if the buffer is too small
+*/
+luminox_retcode_t luminox_save_calibration(uint8_t * blob, uint16_t size, uint16_t * written, luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for setting the temperature compensation curve of the sensor
+
+    @note Applied to ppO2 and O2 in fixed point while decoding, after the calibration, using the temperature of the
+	  same response or the last one decoded before it. The values before compensation stay in sample.ppo2_raw and
+	  sample.o2_raw. The curve is cleared by luminox_init(), so call it afterwards.
+
+    @param[in] points Points of the curve in ascending temperature order, copied into the handler
+
+    @param[in] count Number of points, 0 to turn compensation off
+
+    @return luminox_retcode_t Either success or LUMINOX_ERR_INVALID_ARG if there are too many points
+			      or they aren't in ascending temperature order
+*/
+luminox_retcode_t luminox_set_temp_compensation(const luminox_compensation_point_t * points, uint8_t count, luminox_handler_t * luminox_handler);
+
+#ifdef LUMINOX_HISTORY
+/*
+    @brief Function for getting the history ring of decoded samples
+
+    @note The columns are updated in place by luminox_process_response(), read them between responses
+
+    @return Pointer to the history ring of the handler
+*/
+const luminox_history_t * luminox_get_history(luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for splitting the history ring into contiguous runs from oldest to newest
+
+    @note The first segment holds the oldest samples. The second segment is only used once the ring has
+	  wrapped, otherwise its count is 0. The same segments apply to every column.
+
+    @param[in] history History ring to split
+
+    @param[out] segments Two segments, oldest samples first
+*/
+void luminox_history_segments(const luminox_history_t * history, luminox_history_segment_t segments[2]);
+#endif
+
+#ifdef LUMINOX_ROLLUPS
+/*
+    @brief Function for getting one bucket of a rollup tier
+
+    @note Every decoded value is added to the current minute and hour buckets as it arrives. Periods in which
+	  no response arrived have no bucket, check start. Requires luminox_get_time, without a time source every
+	  value lands in the bucket starting at 0.
+
+    @param[in] tier Minute or hour tier
+
+    @param[in] age 0 for the current bucket, 1 for the one before and so on
+
+    @return Pointer to the bucket, NULL if the tier holds fewer than age + 1 buckets
+*/
+const luminox_rollup_bucket_t * luminox_get_rollup(luminox_rollup_tier_t tier, uint16_t age, luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for getting the number of buckets a rollup tier holds
+
+    @param[in] tier Minute or hour tier
+
+    @return Number of buckets, at most LUMINOX_ROLLUP_MINUTES or LUMINOX_ROLLUP_HOURS
+*/
+uint16_t luminox_rollup_count(luminox_rollup_tier_t tier, luminox_handler_t * luminox_handler);
+#endif
+
 /*
     @brief Function for handling any unsuccessfull requests
 
     @note Called in luminox_process_response if an error message is received from the sensor, 
-	  uses what's in luminox_data[] to process the error
+	  uses what's in luminox_data[] to process the error. An error frame shorter than "E 0x\r"
+	  is reported as LUMINOX_ERR_INVALID_FRAME without reading its code
 
     @return luminox_retcode_t returns one of the defined luminox error codes
 */
@@ -272,7 +1198,12 @@ luminox_retcode_t luminox_error_handler(luminox_handler_t * luminox_handler);
 
     @note The LuminOx sensor responds in ASCII encoded messages
 
-    @note Updates the current_x variables and err_code
+    @note Updates the sample and err_code, then calls the subscribers of the updated fields
+
+    @note Only the bytes before the first terminator are examined and each of them is examined once, so the cost
+	  is bounded by UART_RX_BUF_SIZE no matter what was received. A response without a terminator sets err_code
+	  to LUMINOX_ERR_RX_OVERFLOW, a field cut short by the terminator sets LUMINOX_ERR_INVALID_FRAME.
+	  Fields that don't hold a number (such as "------") are skipped and keep their previous value.
 */
 void luminox_process_response(luminox_handler_t * luminox_handler);
 
@@ -281,9 +1212,32 @@ void luminox_process_response(luminox_handler_t * luminox_handler);
 
     @note First sets the output mode to polling to request and print out sensor information, then sets the output mode
 	  to default mode, which is set to be off. Then resets all of the static variables keeping track of state and recent sensor readings.
+
+    @note Also requests the barometric pressure to detect whether the sensor has a barometric pressure sensor,
+	  unless LUMINOX_NO_BAROMETRIC pins the variant at compile time.
 */
 void luminox_init(luminox_handler_t * luminox_handler);
 
+/*
+    @brief Function for starting a non-blocking initialization of the LuminOx sensor
+
+    @note Sends the same requests as luminox_init() one at a time, each after luminox_process_response() handled the
+	  response of the one before, so many sensors can be brought up at once from one loop. The handler is
+	  initialized once luminox_sequence_busy() returns false and luminox_sequence_result() is LUMINOX_SUCCESS.
+
+    @note luminox_tx must not block. It is called from inside luminox_process_response() for every request after the
+	  first, so a luminox_tx that waits for the response (like the blocking uart_write() in the README) stalls
+	  the loop and brings the sensors up one after another. Copy the request, which is only valid during the
+	  call, into the port's TX buffer, start the transfer and return, e.g.
+	      void uart_write_async(unsigned char * tx, uint8_t size) {
+	          memcpy(port_tx_buf, tx, size);
+	          uart_tx_start(port_tx_buf, size); // interrupt or DMA driven, returns at once
+	      }
+
+    @return luminox_retcode_t Either success or LUMINOX_ERROR if a sequence is already running
+*/
+luminox_retcode_t luminox_init_start(luminox_handler_t * luminox_handler);
+
 /*
     @brief Function for updating the luminox_data array with the most recent response from the LuminOx sensor
 
@@ -292,9 +1246,40 @@ void luminox_init(luminox_handler_t * luminox_handler);
     @param[in] size Size, in bytes, of the response fromthe LuminOx sensor
 
     @note call this function in your uart_event_handler when a complete response from the sensor has been recognized
+
+    @note The sample is timestamped with the time of this call minus the time the response took on the line,
+	  so call it as soon as the terminator arrives
 */
 void luminox_update_data(uint8_t * p_luminox_response, uint8_t size, luminox_handler_t * luminox_handler);
 
+/*
+    @brief Function for receiving the response from the LuminOx sensor one byte at a time
+
+    @param[in] byte Byte received from the sensor
+
+    @note Call this function in your uart_event_handler for every received byte instead of luminox_update_data().
+	  Bytes are collected in rx_buffer and copied to luminox_data once the terminator arrives.
+	  The sample is timestamped with the arrival of the first byte, back-dated by that byte's time on the line,
+	  however late luminox_process_response() is called.
+
+    @return true if the byte completed a response and luminox_process_response() can be called
+*/
+bool luminox_receive_byte(uint8_t byte, luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for getting the name of a trace event
+
+    @return Name of the span the event starts or ends, "unknown" for an invalid event
+*/
+const char * luminox_trace_event_name(luminox_trace_event_t event);
+
+/*
+    @brief Function for getting the Chrome trace event phase of a trace event
+
+    @return 'B' for events that start a span, 'E' for events that end one
+*/
+char luminox_trace_event_phase(luminox_trace_event_t event);
+
 /*
     @brief Function for waiting for response from sensor
 
@@ -0,0 +1,170 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Fleet Store
+
+  @File Name
+    luminox_fleet.c
+
+  @Summary
+    Column store of the latest measurements of many LuminOx sensors
+
+  @Description
+    Implements functions that keep the latest measurements of a fleet of LuminOx sensors in
+    contiguous per-field arrays and query them across the whole fleet
+******************************************************************************/
+
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include "luminox.h"
+#include "luminox_fleet.h"
+
+// the driver never allocates, any use of the heap is a compile error
+#if defined(__GNUC__)
+#pragma GCC poison malloc calloc realloc free
+#endif
+
+/*
+    @brief Function for copying a decoded sample into the sensor's slot
+
+    @note Subscriber callback registered by luminox_fleet_add()
+
+    @param[in] sample Sample decoded by luminox_process_response()
+
+    @param[in] context luminox_fleet_link_t of the sensor
+*/
+static void luminox_fleet_update(const luminox_sample_t * sample, void * context) {
+    const luminox_fleet_link_t * link = context;
+    luminox_fleet_t * fleet = link->fleet;
+    uint16_t slot = link->slot;
+
+    if(sample->fields & LUMINOX_FIELD_PPO2) {
+        fleet->ppo2[slot] = sample->ppo2;
+    }
+    if(sample->fields & LUMINOX_FIELD_O2) {
+        fleet->o2[slot] = sample->o2;
+    }
+    if(sample->fields & LUMINOX_FIELD_TEMP) {
+        fleet->temp[slot] = sample->temp;
+    }
+    if(sample->fields & LUMINOX_FIELD_BAROMETRIC_PRESSURE) {
+        fleet->barometric_pressure[slot] = sample->barometric_pressure;
+    }
+    if(sample->fields & LUMINOX_FIELD_STATUS) {
+        fleet->status[slot] = sample->status;
+    }
+    fleet->timestamp[slot] = sample->timestamp;
+}
+
+/*
+    @brief Function for initializing an empty fleet store
+
+    @param[in] fleet Pointer of the fleet store
+*/
+void luminox_fleet_init(luminox_fleet_t * fleet) {
+    fleet->count = 0;
+}
+
+/*
+    @brief Function for adding a sensor to the fleet store
+
+    @note Subscribes the store to every field of the handler, so call it after luminox_init()
+
+    @param[in] fleet Pointer of the fleet store
+
+    @param[in] luminox_handler Handler of the sensor
+
+    @param[out] slot Slot the sensor's measurements are stored in, may be NULL
+
+    @return luminox_retcode_t Success, or LUMINOX_ERR_FULL if the store or the handler's subscriber table is full
+*/
+luminox_retcode_t luminox_fleet_add(luminox_fleet_t * fleet, luminox_handler_t * luminox_handler, uint16_t * slot) {
+    if(fleet->count >= LUMINOX_FLEET_MAX_SENSORS) {
+        return LUMINOX_ERR_FULL;
+    }
+
+    uint16_t i = fleet->count;
+    fleet->links[i].fleet = fleet;
+    fleet->links[i].slot = i;
+    luminox_retcode_t ret = luminox_subscribe(luminox_fleet_update, &fleet->links[i], LUMINOX_FIELD_ALL, luminox_handler);
+    if(ret != LUMINOX_SUCCESS) {
+        return ret;
+    }
+
+    fleet->ppo2[i] = NAN;
+    fleet->o2[i] = NAN;
+    fleet->temp[i] = NAN;
+    fleet->barometric_pressure[i] = NAN;
+    fleet->status[i] = 0;
+    fleet->timestamp[i] = 0;
+    fleet->count++;
+
+    if(slot != NULL) {
+        *slot = i;
+    }
+    return LUMINOX_SUCCESS;
+}
+
+/*
+    @brief Function for getting one column of the fleet store
+
+    @param[in] fleet Pointer of the fleet store
+
+    @param[in] field Single float field: ppO2, O2, temperature or barometric pressure
+
+    @return Pointer to count values indexed by slot, NULL for any other field
+*/
+const float * luminox_fleet_column(const luminox_fleet_t * fleet, luminox_field_t field) {
+    switch(field) {
+        case LUMINOX_FIELD_PPO2:
+            return fleet->ppo2;
+        case LUMINOX_FIELD_O2:
+            return fleet->o2;
+        case LUMINOX_FIELD_TEMP:
+            return fleet->temp;
+        case LUMINOX_FIELD_BAROMETRIC_PRESSURE:
+            return fleet->barometric_pressure;
+        default:
+            return NULL;
+    }
+}
+
+/*
+    @brief Function for checking if any sensor in the fleet reads below a threshold
+
+    @note Scans the whole column without branching so the compiler can vectorise it
+
+    @param[in] fleet Pointer of the fleet store
+
+    @param[in] field Single float field: ppO2, O2, temperature or barometric pressure
+
+    @param[in] threshold Value to compare against
+
+    @return true if at least one sensor's latest value of field is below threshold
+*/
+bool luminox_fleet_any_below(const luminox_fleet_t * fleet, luminox_field_t field, float threshold) {
+    return luminox_fleet_count_below(fleet, field, threshold) > 0;
+}
+
+/*
+    @brief Function for counting the sensors in the fleet that read below a threshold
+
+    @param[in] fleet Pointer of the fleet store
+
+    @param[in] field Single float field: ppO2, O2, temperature or barometric pressure
+
+    @param[in] threshold Value to compare against
+
+    @return Number of sensors whose latest value of field is below threshold
+*/
+uint16_t luminox_fleet_count_below(const luminox_fleet_t * fleet, luminox_field_t field, float threshold) {
+    const float * column = luminox_fleet_column(fleet, field);
+    if(column == NULL) {
+        return 0;
+    }
+    uint32_t below = 0;
+    for(uint16_t i = 0; i < fleet->count; i++) {
+        below += (column[i] < threshold); // NAN compares false, so silent slots never count
+    }
+    return (uint16_t)below;
+}
@@ -0,0 +1,131 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Fleet Store
+
+  @File Name
+    luminox_fleet.h
+
+  @Summary
+    Column store of the latest measurements of many LuminOx sensors
+
+  @Description
+    Defines functions that keep the latest measurements of a fleet of LuminOx sensors in
+    contiguous per-field arrays and query them across the whole fleet
+******************************************************************************/
+
+#ifndef LUMINOX_FLEET_H
+#define LUMINOX_FLEET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "luminox.h"
+
+/*
+    Number of sensors one fleet store holds, every column is statically allocated in luminox_fleet_t
+*/
+#ifndef LUMINOX_FLEET_MAX_SENSORS
+#define LUMINOX_FLEET_MAX_SENSORS 256
+#endif
+#if LUMINOX_FLEET_MAX_SENSORS > 65535 || LUMINOX_FLEET_MAX_SENSORS < 1
+#error "LUMINOX_FLEET_MAX_SENSORS must be 1 to 65535"
+#endif
+
+/*
+    Columns are aligned to a cache line so a scan of one field never shares lines with another field
+    and the compiler can use aligned vector loads
+*/
+#ifndef LUMINOX_CACHE_LINE_SIZE
+#define LUMINOX_CACHE_LINE_SIZE 64
+#endif
+#if defined(__GNUC__)
+#define LUMINOX_CACHE_ALIGNED __attribute__((aligned(LUMINOX_CACHE_LINE_SIZE)))
+#else
+#define LUMINOX_CACHE_ALIGNED _Alignas(LUMINOX_CACHE_LINE_SIZE)
+#endif
+
+struct luminox_fleet;
+
+// @brief subscriber context linking a handler to its slot in the fleet store
+typedef struct {
+    struct luminox_fleet * fleet;
+    uint16_t slot;
+} luminox_fleet_link_t;
+
+/*
+    luminox fleet store struct, one column per field indexed by slot.
+    Only the hot measurement values live here, the RX buffers stay in the handlers.
+    Slots that have not reported a field yet hold NAN, which never matches a query.
+*/
+typedef struct luminox_fleet {
+    LUMINOX_CACHE_ALIGNED float ppo2[LUMINOX_FLEET_MAX_SENSORS];
+    LUMINOX_CACHE_ALIGNED float o2[LUMINOX_FLEET_MAX_SENSORS];
+    LUMINOX_CACHE_ALIGNED float temp[LUMINOX_FLEET_MAX_SENSORS];
+    LUMINOX_CACHE_ALIGNED float barometric_pressure[LUMINOX_FLEET_MAX_SENSORS];
+    LUMINOX_CACHE_ALIGNED uint16_t status[LUMINOX_FLEET_MAX_SENSORS];
+    LUMINOX_CACHE_ALIGNED uint32_t timestamp[LUMINOX_FLEET_MAX_SENSORS]; // time of the last sample of the slot
+    luminox_fleet_link_t links[LUMINOX_FLEET_MAX_SENSORS]; // cold, only touched when a sample arrives
+    uint16_t count; // number of slots in use
+} luminox_fleet_t;
+
+/*
+    @brief Function for initializing an empty fleet store
+
+    @param[in] fleet Pointer of the fleet store
+*/
+void luminox_fleet_init(luminox_fleet_t * fleet);
+
+/*
+    @brief Function for adding a sensor to the fleet store
+
+    @note Subscribes the store to every field of the handler, so call it after luminox_init()
+
+    @param[in] fleet Pointer of the fleet store
+
+    @param[in] luminox_handler Handler of the sensor
+
+    @param[out] slot Slot the sensor's measurements are stored in, may be NULL
+
+    @return luminox_retcode_t Success, or LUMINOX_ERR_FULL if the store or the handler's subscriber table is full
+*/
+luminox_retcode_t luminox_fleet_add(luminox_fleet_t * fleet, luminox_handler_t * luminox_handler, uint16_t * slot);
+
+/*
+    @brief Function for getting one column of the fleet store
+
+    @param[in] fleet Pointer of the fleet store
+
+    @param[in] field Single float field: ppO2, O2, temperature or barometric pressure
+
+    @return Pointer to count values indexed by slot, NULL for any other field
+*/
+const float * luminox_fleet_column(const luminox_fleet_t * fleet, luminox_field_t field);
+
+/*
+    @brief Function for checking if any sensor in the fleet reads below a threshold
+
+    @note Scans the whole column without branching so the compiler can vectorise it
+
+    @param[in] fleet Pointer of the fleet store
+
+    @param[in] field Single float field: ppO2, O2, temperature or barometric pressure
+
+    @param[in] threshold Value to compare against
+
+    @return true if at least one sensor's latest value of field is below threshold
+*/
+bool luminox_fleet_any_below(const luminox_fleet_t * fleet, luminox_field_t field, float threshold);
+
+/*
+    @brief Function for counting the sensors in the fleet that read below a threshold
+
+    @param[in] fleet Pointer of the fleet store
+
+    @param[in] field Single float field: ppO2, O2, temperature or barometric pressure
+
+    @param[in] threshold Value to compare against
+
+    @return Number of sensors whose latest value of field is below threshold
+*/
+uint16_t luminox_fleet_count_below(const luminox_fleet_t * fleet, luminox_field_t field, float threshold);
+
+
+#endif // LUMINOX_FLEET_H
@@ -0,0 +1,318 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Query Protocol
+
+  @File Name
+    luminox_query.c
+
+  @Summary
+    Compact binary query protocol and text metrics for LuminOx handlers
+
+  @Description
+    Implements functions that answer queries about a LuminOx handler from its in-memory state,
+    so a gateway can serve many clients without touching the sensor's UART
+******************************************************************************/
+
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "luminox.h"
+#include "luminox_query.h"
+
+// the driver never allocates, any use of the heap is a compile error
+#if defined(__GNUC__)
+#pragma GCC poison malloc calloc realloc free
+#endif
+
+#define LUMINOX_QUERY_SNAPSHOT_SIZE 28 // 2 u32, 2 u8, 4 f32, u16
+#define LUMINOX_QUERY_COUNTERS_SIZE 17
+#define LUMINOX_QUERY_IDENTITY_SIZE (3 * LUMINOX_INFO_SIZE + 1)
+
+/*
+    @brief Function for writing a little endian uint16
+
+    @return Pointer past the written bytes
+*/
+static uint8_t * luminox_query_put_u16(uint8_t * p, uint16_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    return p + 2;
+}
+
+/*
+    @brief Function for writing a little endian uint32
+
+    @return Pointer past the written bytes
+*/
+static uint8_t * luminox_query_put_u32(uint8_t * p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+    return p + 4;
+}
+
+/*
+    @brief Function for writing a little endian IEEE 754 float
+
+    @return Pointer past the written bytes
+*/
+static uint8_t * luminox_query_put_float(uint8_t * p, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return luminox_query_put_u32(p, bits);
+}
+
+/*
+    @brief Function for reading a little endian uint32
+
+    @return Decoded value
+*/
+static uint32_t luminox_query_get_u32(const uint8_t * p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*
+    @brief Function for writing the samples of the history that fall inside a time range
+
+    @param[out] p Buffer for the count and the samples
+
+    @param[in] capacity Space left in the buffer
+
+    @param[in] from First timestamp to include
+
+    @param[in] to Last timestamp to include
+
+    @param[in] history History ring of the handler
+
+    @return Pointer past the written bytes
+*/
+static uint8_t * luminox_query_put_history(uint8_t * p, uint16_t capacity, uint32_t from, uint32_t to, const luminox_history_t * history) {
+    luminox_history_segment_t segments[2];
+    luminox_history_segments(history, segments);
+    uint8_t * count_field = p;
+    uint16_t count = 0;
+    uint16_t max_count = (capacity - 2) / LUMINOX_QUERY_SAMPLE_SIZE;
+    p += 2;
+
+    for(uint8_t s = 0; s < 2; s++) {
+        for(uint16_t i = segments[s].start; i < segments[s].start + segments[s].count && count < max_count; i++) {
+            if(history->timestamp[i] < from || history->timestamp[i] > to) {
+                continue;
+            }
+            p = luminox_query_put_u32(p, history->timestamp[i]);
+            *p++ = history->fields[i];
+            p = luminox_query_put_float(p, history->ppo2[i]);
+            p = luminox_query_put_float(p, history->o2[i]);
+            p = luminox_query_put_float(p, history->temp[i]);
+            p = luminox_query_put_float(p, history->barometric_pressure[i]);
+            p = luminox_query_put_u16(p, history->status[i]);
+            count++;
+        }
+    }
+    luminox_query_put_u16(count_field, count);
+    return p;
+}
+
+/*
+    @brief Function for answering one query
+
+    @note Only reads the handler, so it can run between two responses of the sensor from the same loop that
+	  drives it. A history query returns as many matching samples as fit in the response buffer.
+
+    @param[in] request Query received from a client
+
+    @param[in] request_size Size of the query in bytes
+
+    @param[out] response Buffer for the response
+
+    @param[in] response_capacity Size of the response buffer in bytes, at least LUMINOX_QUERY_HEADER_SIZE
+
+    @param[out] response_size Number of bytes written to response
+
+    @param[in] luminox_handler Handler of the sensor the query is about
+
+    @return luminox_retcode_t Status also written to the response, LUMINOX_ERR_INVALID_CMD for an unknown opcode,
+			      LUMINOX_ERR_INVALID_FRAME for a short request or LUMINOX_ERR_FULL if the answer doesn't fit
+*/
+luminox_retcode_t luminox_query_handle(const uint8_t * request, uint16_t request_size, uint8_t * response, uint16_t response_capacity, uint16_t * response_size, luminox_handler_t * luminox_handler) {
+    luminox_retcode_t ret = LUMINOX_SUCCESS;
+    uint16_t capacity = response_capacity - LUMINOX_QUERY_HEADER_SIZE;
+    uint8_t * p = response + LUMINOX_QUERY_HEADER_SIZE;
+    *response_size = 0;
+    if(response_capacity < LUMINOX_QUERY_HEADER_SIZE) {
+        return LUMINOX_ERR_FULL;
+    }
+    if(request_size < 1) {
+        ret = LUMINOX_ERR_INVALID_FRAME;
+        goto Done;
+    }
+
+    switch(request[0]) {
+        case LUMINOX_QUERY_SNAPSHOT: {
+            const luminox_sample_t * sample = &luminox_handler->sample;
+            if(capacity < LUMINOX_QUERY_SNAPSHOT_SIZE) {
+                ret = LUMINOX_ERR_FULL;
+                break;
+            }
+            p = luminox_query_put_u32(p, sample->sequence);
+            p = luminox_query_put_u32(p, sample->timestamp);
+            *p++ = sample->fields;
+            *p++ = sample->missing;
+            p = luminox_query_put_float(p, sample->ppo2);
+            p = luminox_query_put_float(p, sample->o2);
+            p = luminox_query_put_float(p, sample->temp);
+            p = luminox_query_put_float(p, sample->barometric_pressure);
+            p = luminox_query_put_u16(p, sample->status);
+            break;
+        }
+        case LUMINOX_QUERY_HISTORY:
+            if(request_size < 9) {
+                ret = LUMINOX_ERR_INVALID_FRAME;
+                break;
+            }
+            if(capacity < 2) {
+                ret = LUMINOX_ERR_FULL;
+                break;
+            }
+            p = luminox_query_put_history(p, capacity, luminox_query_get_u32(&request[1]), luminox_query_get_u32(&request[5]), luminox_get_history(luminox_handler));
+            break;
+        case LUMINOX_QUERY_COUNTERS:
+            if(capacity < LUMINOX_QUERY_COUNTERS_SIZE) {
+                ret = LUMINOX_ERR_FULL;
+                break;
+            }
+            p = luminox_query_put_u32(p, luminox_handler->tx_bytes_total);
+            p = luminox_query_put_u32(p, luminox_handler->rx_bytes_total);
+            p = luminox_query_put_u32(p, luminox_handler->sample.sequence);
+            p = luminox_query_put_u32(p, luminox_get_response_latency(luminox_handler));
+            *p++ = (uint8_t)luminox_handler->err_code;
+            break;
+        case LUMINOX_QUERY_IDENTITY: {
+            const luminox_identity_t * identity = luminox_get_identity(luminox_handler);
+            if(capacity < LUMINOX_QUERY_IDENTITY_SIZE) {
+                ret = LUMINOX_ERR_FULL;
+                break;
+            }
+            memcpy(p, identity->date_of_mfg, LUMINOX_INFO_SIZE);
+            p += LUMINOX_INFO_SIZE;
+            memcpy(p, identity->serial_number, LUMINOX_INFO_SIZE);
+            p += LUMINOX_INFO_SIZE;
+            memcpy(p, identity->sw_version, LUMINOX_INFO_SIZE);
+            p += LUMINOX_INFO_SIZE;
+            *p++ = (uint8_t)luminox_get_variant(luminox_handler);
+            break;
+        }
+        default:
+            ret = LUMINOX_ERR_INVALID_CMD;
+            break;
+    }
+
+    Done:
+    if(ret != LUMINOX_SUCCESS) {
+        p = response + LUMINOX_QUERY_HEADER_SIZE; // errors carry no payload
+    }
+    response[0] = (request_size > 0) ? request[0] : 0;
+    response[1] = (uint8_t)ret;
+    *response_size = (uint16_t)(p - response);
+    return ret;
+}
+
+/*
+    @brief Function for appending text to the metrics
+
+    @param[out] buffer Buffer for the text, always zero terminated
+
+    @param[in] size Size of the buffer in bytes
+
+    @param[in] length Characters written before, or that would have been written, negative after an error
+
+    @return length plus the characters of this text, or negative after an error
+*/
+static int luminox_query_append(char * buffer, uint16_t size, int length, const char * format, ...) {
+    if(length < 0) {
+        return length;
+    }
+    uint16_t used = (length < size) ? (uint16_t)length : size; // a full buffer keeps its terminating zero
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buffer + used, size - used, format, args);
+    va_end(args);
+    return (written < 0) ? written : length + written;
+}
+
+/*
+    @brief Function for escaping a label value as the Prometheus text format requires
+
+    @note A noisy line can put any byte into the identity, an unescaped quote or newline would end the label
+	  or the line and let the rest pass as metrics of its own.
+
+    @param[out] label Escaped value, zero terminated, holds 2 * LUMINOX_INFO_SIZE characters
+
+    @param[in] value Zero terminated value of at most LUMINOX_INFO_SIZE - 1 characters
+*/
+static void luminox_query_escape(char * label, const char * value) {
+    for(uint8_t i = 0; i < LUMINOX_INFO_SIZE - 1 && value[i] != '\0'; i++) {
+        if(value[i] == '\\' || value[i] == '"') {
+            *label++ = '\\';
+            *label++ = value[i];
+        } else if(value[i] == '\n') {
+            *label++ = '\\';
+            *label++ = 'n';
+        } else {
+            *label++ = value[i];
+        }
+    }
+    *label = '\0';
+}
+
+/*
+    @brief Function for writing the handler's state as text metrics for scraping
+
+    @note One line per metric in the Prometheus text format, labelled with the sensor's serial number with
+	  backslashes, quotes and newlines escaped.
+	  The barometric pressure is left out while luminox_barometric_pressure_valid() is false.
+
+    @param[out] buffer Buffer for the text, always zero terminated
+
+    @param[in] size Size of the buffer in bytes
+
+    @param[in] luminox_handler Handler of the sensor
+
+    @return Number of characters written, not counting the terminating zero, or the number that would have
+	    been written if the buffer is too small
+*/
+int luminox_query_metrics(char * buffer, uint16_t size, luminox_handler_t * luminox_handler) {
+    const luminox_sample_t * sample = &luminox_handler->sample;
+    char serial[2 * LUMINOX_INFO_SIZE];
+    luminox_query_escape(serial, luminox_get_identity(luminox_handler)->serial_number);
+    int length = 0;
+    if(size > 0) {
+        buffer[0] = '\0';
+    }
+
+    length = luminox_query_append(buffer, size, length,
+        "luminox_ppo2_mbar{serial=\"%s\"} %.1f\n"
+        "luminox_o2_percent{serial=\"%s\"} %.2f\n"
+        "luminox_temperature_celsius{serial=\"%s\"} %.1f\n",
+        serial, sample->ppo2,
+        serial, sample->o2,
+        serial, sample->temp);
+    if(luminox_barometric_pressure_valid(luminox_handler)) {
+        length = luminox_query_append(buffer, size, length,
+            "luminox_barometric_pressure_mbar{serial=\"%s\"} %.0f\n",
+            serial, sample->barometric_pressure);
+    }
+    return luminox_query_append(buffer, size, length,
+        "luminox_status{serial=\"%s\"} %u\n"
+        "luminox_samples_total{serial=\"%s\"} %lu\n"
+        "luminox_tx_bytes_total{serial=\"%s\"} %lu\n"
+        "luminox_rx_bytes_total{serial=\"%s\"} %lu\n"
+        "luminox_response_latency_ms{serial=\"%s\"} %lu\n",
+        serial, (unsigned)sample->status,
+        serial, (unsigned long)sample->sequence,
+        serial, (unsigned long)luminox_handler->tx_bytes_total,
+        serial, (unsigned long)luminox_handler->rx_bytes_total,
+        serial, (unsigned long)luminox_get_response_latency(luminox_handler));
+}
@@ -0,0 +1,93 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Query Protocol
+
+  @File Name
+    luminox_query.h
+
+  @Summary
+    Compact binary query protocol and text metrics for LuminOx handlers
+
+  @Description
+    Defines functions that answer queries about a LuminOx handler from its in-memory state,
+    so a gateway can serve many clients without touching the sensor's UART
+******************************************************************************/
+
+#ifndef LUMINOX_QUERY_H
+#define LUMINOX_QUERY_H
+
+#include <stdint.h>
+#include "luminox.h"
+
+#ifndef LUMINOX_HISTORY
+#error "the query protocol serves the history ring, define LUMINOX_HISTORY"
+#endif
+
+/*
+    Query requests start with one of these opcodes, responses start with the same opcode followed by a
+    luminox_retcode_t status byte. All multi byte values are little endian, floats are IEEE 754 single precision.
+
+    LUMINOX_QUERY_SNAPSHOT   request: opcode
+                             response: sequence u32, timestamp u32, fields u8, missing u8,
+                                       ppO2 f32, O2 f32, temp f32, pressure f32, status u16
+    LUMINOX_QUERY_HISTORY    request: opcode, from u32, to u32 (timestamps, inclusive)
+                             response: count u16, then count samples oldest first of
+                                       timestamp u32, fields u8, ppO2 f32, O2 f32, temp f32, pressure f32, status u16
+    LUMINOX_QUERY_COUNTERS   request: opcode
+                             response: tx bytes u32, rx bytes u32, samples u32, response latency u32, err_code u8
+    LUMINOX_QUERY_IDENTITY   request: opcode
+                             response: date of mfg, serial number and sw version as LUMINOX_INFO_SIZE byte
+                                       zero padded strings, variant u8
+*/
+typedef enum {
+    LUMINOX_QUERY_SNAPSHOT = 0x01,
+    LUMINOX_QUERY_HISTORY = 0x02,
+    LUMINOX_QUERY_COUNTERS = 0x03,
+    LUMINOX_QUERY_IDENTITY = 0x04
+} luminox_query_opcode_t;
+
+#define LUMINOX_QUERY_HEADER_SIZE 2 // opcode, status
+#define LUMINOX_QUERY_SAMPLE_SIZE 23 // one history sample in a LUMINOX_QUERY_HISTORY response
+
+/*
+    @brief Function for answering one query
+
+    @note Only reads the handler, so it can run between two responses of the sensor from the same loop that
+	  drives it. A history query returns as many matching samples as fit in the response buffer.
+
+    @param[in] request Query received from a client
+
+    @param[in] request_size Size of the query in bytes
+
+    @param[out] response Buffer for the response
+
+    @param[in] response_capacity Size of the response buffer in bytes, at least LUMINOX_QUERY_HEADER_SIZE
+
+    @param[out] response_size Number of bytes written to response
+
+    @param[in] luminox_handler Handler of the sensor the query is about
+
+    @return luminox_retcode_t Status also written to the response, LUMINOX_ERR_INVALID_CMD for an unknown opcode,
+			      LUMINOX_ERR_INVALID_FRAME for a short request or LUMINOX_ERR_FULL if the answer doesn't fit
+*/
+luminox_retcode_t luminox_query_handle(const uint8_t * request, uint16_t request_size, uint8_t * response, uint16_t response_capacity, uint16_t * response_size, luminox_handler_t * luminox_handler);
+
+/*
+    @brief Function for writing the handler's state as text metrics for scraping
+
+    @note One line per metric in the Prometheus text format, labelled with the sensor's serial number with
+	  backslashes, quotes and newlines escaped.
+	  The barometric pressure is left out while luminox_barometric_pressure_valid() is false.
+
+    @param[out] buffer Buffer for the text, always zero terminated
+
+    @param[in] size Size of the buffer in bytes
+
+    @param[in] luminox_handler Handler of the sensor
+
+    @return Number of characters written, not counting the terminating zero, or the number that would have
+	    been written if the buffer is too small
+*/
+int luminox_query_metrics(char * buffer, uint16_t size, luminox_handler_t * luminox_handler);
+
+
+#endif // LUMINOX_QUERY_H
@@ -0,0 +1,246 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Resampler
+
+  @File Name
+    luminox_resample.c
+
+  @Summary
+    Resampling of several LuminOx sensors onto a common time grid
+
+  @Description
+    Implements functions that collect the timestamped samples of several LuminOx sensors and produce
+    rows of values aligned on a shared time grid, interpolated or held, with staleness flags
+******************************************************************************/
+
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <math.h>
+#include "luminox.h"
+#include "luminox_resample.h"
+
+// the driver never allocates, any use of the heap is a compile error
+#if defined(__GNUC__)
+#pragma GCC poison malloc calloc realloc free
+#endif
+
+/*
+    @brief Function for comparing two times that may have wrapped around
+
+    @return true if a is before b
+*/
+static bool luminox_resample_before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+/*
+    @brief Function for getting the value of a float field of a sample
+
+    @param[in] sample Decoded sample
+
+    @param[in] field Single float field
+
+    @return Value of the field
+*/
+static float luminox_resample_field(const luminox_sample_t * sample, uint8_t field) {
+    switch(field) {
+        case LUMINOX_FIELD_PPO2:
+            return sample->ppo2;
+        case LUMINOX_FIELD_O2:
+            return sample->o2;
+        case LUMINOX_FIELD_TEMP:
+            return sample->temp;
+        default:
+            return sample->barometric_pressure;
+    }
+}
+
+/*
+    @brief Function for storing a sample of a sensor
+
+    @note Subscriber callback registered by luminox_resample_add(), overwrites the oldest sample when full
+
+    @param[in] sample Sample decoded by luminox_process_response()
+
+    @param[in] context luminox_resample_sensor_t of the sensor
+*/
+static void luminox_resample_update(const luminox_sample_t * sample, void * context) {
+    luminox_resample_sensor_t * sensor = context;
+    luminox_resampler_t * resampler = sensor->resampler;
+
+    sensor->value[sensor->head] = luminox_resample_field(sample, resampler->field);
+    sensor->time[sensor->head] = sample->timestamp;
+    sensor->head = (sensor->head + 1 < LUMINOX_RESAMPLE_DEPTH) ? sensor->head + 1 : 0;
+    if(sensor->count < LUMINOX_RESAMPLE_DEPTH) {
+        sensor->count++;
+    }
+
+    if(!resampler->started) {
+        // first row on the first grid time at or after the first sample
+        uint32_t offset = sample->timestamp % resampler->period_ms;
+        resampler->next_time = sample->timestamp + (offset ? resampler->period_ms - offset : 0);
+        resampler->started = true;
+    }
+}
+
+/*
+    @brief Function for getting the index of the n-th newest sample of a sensor
+
+    @param[in] sensor Samples of the sensor
+
+    @param[in] age 0 for the newest sample
+
+    @return Index into the sample arrays
+*/
+static uint8_t luminox_resample_index(const luminox_resample_sensor_t * sensor, uint8_t age) {
+    int16_t index = (int16_t)sensor->head - 1 - age;
+    return (uint8_t)((index < 0) ? index + LUMINOX_RESAMPLE_DEPTH : index);
+}
+
+/*
+    @brief Function for computing the value of a sensor at a grid time
+
+    @param[in] resampler Pointer of the resampler
+
+    @param[in] sensor Samples of the sensor
+
+    @param[in] time Grid time
+
+    @param[out] value Value at the grid time, NAN if no sample at or before it is left
+
+    @return true if the value is stale. An interpolated value is only fresh if both samples are within max_age_ms
+	    of each other, across a longer gap the value before it is held and marked stale
+*/
+static bool luminox_resample_value(const luminox_resampler_t * resampler, const luminox_resample_sensor_t * sensor, uint32_t time, float * value) {
+    // newest sample at or before the grid time, and the one after it
+    for(uint8_t age = 0; age < sensor->count; age++) {
+        uint8_t before = luminox_resample_index(sensor, age);
+        if(luminox_resample_before(time, sensor->time[before])) {
+            continue;
+        }
+        *value = sensor->value[before];
+        if(age > 0 && resampler->mode == LUMINOX_RESAMPLE_LINEAR) {
+            uint8_t after = luminox_resample_index(sensor, age - 1);
+            uint32_t span = sensor->time[after] - sensor->time[before];
+            if(span > resampler->max_age_ms) {
+                return true; // a gap, hold the value before it rather than make up data across it
+            }
+            if(span > 0) {
+                *value += (sensor->value[after] - sensor->value[before]) * (float)(time - sensor->time[before]) / (float)span;
+            }
+            return false;
+        }
+        return time - sensor->time[before] > resampler->max_age_ms;
+    }
+    *value = NAN;
+    return true;
+}
+
+/*
+    @brief Function for initializing an empty resampler
+
+    @param[in] resampler Pointer of the resampler
+
+    @param[in] field Single float field to resample: ppO2, O2, temperature or barometric pressure
+
+    @param[in] mode Linear interpolation or zero-order hold
+
+    @param[in] period_ms Spacing of the grid, the rows fall on multiples of it
+
+    @param[in] max_age_ms A value taken from a sample further than this from the row time is marked stale,
+			  linear mode only interpolates between samples at most this far apart,
+			  and a row is produced at the latest this long after its time
+
+    @return luminox_retcode_t Either success or LUMINOX_ERR_INVALID_ARG for an invalid field or a period of 0
+*/
+luminox_retcode_t luminox_resample_init(luminox_resampler_t * resampler, luminox_field_t field, luminox_resample_mode_t mode, uint32_t period_ms, uint32_t max_age_ms) {
+    if((field != LUMINOX_FIELD_PPO2 && field != LUMINOX_FIELD_O2 && field != LUMINOX_FIELD_TEMP && field != LUMINOX_FIELD_BAROMETRIC_PRESSURE)
+        || period_ms == 0) {
+        return LUMINOX_ERR_INVALID_ARG;
+    }
+    resampler->count = 0;
+    resampler->field = (uint8_t)field;
+    resampler->mode = mode;
+    resampler->period_ms = period_ms;
+    resampler->max_age_ms = max_age_ms;
+    resampler->next_time = 0;
+    resampler->started = false;
+    return LUMINOX_SUCCESS;
+}
+
+/*
+    @brief Function for adding a sensor to the resampler
+
+    @note Subscribes the resampler to the field of the handler, so call it after luminox_init().
+	  Timestamps come from the samples, so every handler needs luminox_get_time on the same clock.
+
+    @param[in] resampler Pointer of the resampler
+
+    @param[in] luminox_handler Handler of the sensor
+
+    @param[out] sensor Column of the sensor in the rows, may be NULL
+
+    @return luminox_retcode_t Success, or LUMINOX_ERR_FULL if the resampler or the handler's subscriber table is full
+*/
+luminox_retcode_t luminox_resample_add(luminox_resampler_t * resampler, luminox_handler_t * luminox_handler, uint8_t * sensor) {
+    if(resampler->count >= LUMINOX_RESAMPLE_MAX_SENSORS) {
+        return LUMINOX_ERR_FULL;
+    }
+
+    uint8_t i = resampler->count;
+    resampler->sensors[i].resampler = resampler;
+    resampler->sensors[i].head = 0;
+    resampler->sensors[i].count = 0;
+    luminox_retcode_t ret = luminox_subscribe(luminox_resample_update, &resampler->sensors[i], (luminox_field_t)resampler->field, luminox_handler);
+    if(ret != LUMINOX_SUCCESS) {
+        return ret;
+    }
+    resampler->count++;
+
+    if(sensor != NULL) {
+        *sensor = i;
+    }
+    return LUMINOX_SUCCESS;
+}
+
+/*
+    @brief Function for getting the next aligned row
+
+    @note A row is ready once every sensor sent a sample at or after its time, or max_age_ms after its time.
+	  Call it until it returns false, e.g. after every luminox_process_response() or from a timer.
+
+    @param[in] resampler Pointer of the resampler
+
+    @param[in] now Current time in milliseconds, on the clock of the samples
+
+    @param[out] row Filled in with the row if one is ready
+
+    @return true if a row was produced
+*/
+bool luminox_resample_poll(luminox_resampler_t * resampler, uint32_t now, luminox_resample_row_t * row) {
+    if(!resampler->started) {
+        return false;
+    }
+    uint32_t time = resampler->next_time;
+
+    // wait for every sensor to pass the grid time, but no longer than max_age_ms
+    if(now - time < resampler->max_age_ms || luminox_resample_before(now, time)) {
+        for(uint8_t i = 0; i < resampler->count; i++) {
+            const luminox_resample_sensor_t * sensor = &resampler->sensors[i];
+            if(sensor->count == 0 || luminox_resample_before(sensor->time[luminox_resample_index(sensor, 0)], time)) {
+                return false;
+            }
+        }
+    }
+
+    row->time = time;
+    row->stale = 0;
+    for(uint8_t i = 0; i < resampler->count; i++) {
+        if(luminox_resample_value(resampler, &resampler->sensors[i], time, &row->value[i])) {
+            row->stale |= (uint32_t)1 << i;
+        }
+    }
+    resampler->next_time = time + resampler->period_ms;
+    return true;
+}
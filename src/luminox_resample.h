@@ -0,0 +1,131 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Resampler
+
+  @File Name
+    luminox_resample.h
+
+  @Summary
+    Resampling of several LuminOx sensors onto a common time grid
+
+  @Description
+    Defines functions that collect the timestamped samples of several LuminOx sensors and produce
+    rows of values aligned on a shared time grid, interpolated or held, with staleness flags
+******************************************************************************/
+
+#ifndef LUMINOX_RESAMPLE_H
+#define LUMINOX_RESAMPLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "luminox.h"
+
+/*
+    Number of sensors one resampler aligns, limited to the 32 bits of the stale mask of a row
+*/
+#ifndef LUMINOX_RESAMPLE_MAX_SENSORS
+#define LUMINOX_RESAMPLE_MAX_SENSORS 8
+#endif
+#if LUMINOX_RESAMPLE_MAX_SENSORS > 32 || LUMINOX_RESAMPLE_MAX_SENSORS < 1
+#error "LUMINOX_RESAMPLE_MAX_SENSORS must be 1 to 32"
+#endif
+
+/*
+    Number of recent samples kept per sensor. It must cover the samples a fast sensor sends while a row waits
+    for the slowest one, at most max_age_ms worth.
+*/
+#ifndef LUMINOX_RESAMPLE_DEPTH
+#define LUMINOX_RESAMPLE_DEPTH 4
+#endif
+#if LUMINOX_RESAMPLE_DEPTH > 255 || LUMINOX_RESAMPLE_DEPTH < 2
+#error "LUMINOX_RESAMPLE_DEPTH must be 2 to 255"
+#endif
+
+// @brief how a value between two samples is computed
+typedef enum {
+    LUMINOX_RESAMPLE_LINEAR = 0, // interpolate between the samples before and after the grid time
+    LUMINOX_RESAMPLE_HOLD // zero-order hold, the last sample at or before the grid time
+} luminox_resample_mode_t;
+
+struct luminox_resampler;
+
+// @brief recent samples of one sensor, also the subscriber context linking its handler to the resampler
+typedef struct {
+    struct luminox_resampler * resampler;
+    float value[LUMINOX_RESAMPLE_DEPTH];
+    uint32_t time[LUMINOX_RESAMPLE_DEPTH];
+    uint8_t head; // index the next sample is written to
+    uint8_t count; // number of samples stored
+} luminox_resample_sensor_t;
+
+// @brief one aligned row, value n belongs to the sensor added n-th
+typedef struct {
+    uint32_t time; // grid time of the row in milliseconds
+    float value[LUMINOX_RESAMPLE_MAX_SENSORS]; // NAN for a sensor without a sample around time
+    uint32_t stale; // bit n is set if value n is NAN, held from a sample further than max_age_ms from time, or held across a gap longer than max_age_ms instead of interpolated
+} luminox_resample_row_t;
+
+// luminox resampler struct
+typedef struct luminox_resampler {
+    luminox_resample_sensor_t sensors[LUMINOX_RESAMPLE_MAX_SENSORS];
+    uint8_t count; // number of sensors added
+    uint8_t field; // single float luminox_field_t that is resampled
+    luminox_resample_mode_t mode;
+    uint32_t period_ms; // spacing of the grid
+    uint32_t max_age_ms; // staleness limit and longest time a row waits for a sensor
+    uint32_t next_time; // grid time of the next row
+    bool started; // next_time is set, after the first sample
+} luminox_resampler_t;
+
+/*
+    @brief Function for initializing an empty resampler
+
+    @param[in] resampler Pointer of the resampler
+
+    @param[in] field Single float field to resample: ppO2, O2, temperature or barometric pressure
+
+    @param[in] mode Linear interpolation or zero-order hold
+
+    @param[in] period_ms Spacing of the grid, the rows fall on multiples of it
+
+    @param[in] max_age_ms A value taken from a sample further than this from the row time is marked stale,
+			  linear mode only interpolates between samples at most this far apart,
+			  and a row is produced at the latest this long after its time
+
+    @return luminox_retcode_t Either success or LUMINOX_ERR_INVALID_ARG for an invalid field or a period of 0
+*/
+luminox_retcode_t luminox_resample_init(luminox_resampler_t * resampler, luminox_field_t field, luminox_resample_mode_t mode, uint32_t period_ms, uint32_t max_age_ms);
+
+/*
+    @brief Function for adding a sensor to the resampler
+
+    @note Subscribes the resampler to the field of the handler, so call it after luminox_init().
+	  Timestamps come from the samples, so every handler needs luminox_get_time on the same clock.
+
+    @param[in] resampler Pointer of the resampler
+
+    @param[in] luminox_handler Handler of the sensor
+
+    @param[out] sensor Column of the sensor in the rows, may be NULL
+
+    @return luminox_retcode_t Success, or LUMINOX_ERR_FULL if the resampler or the handler's subscriber table is full
+*/
+luminox_retcode_t luminox_resample_add(luminox_resampler_t * resampler, luminox_handler_t * luminox_handler, uint8_t * sensor);
+
+/*
+    @brief Function for getting the next aligned row
+
+    @note A row is ready once every sensor sent a sample at or after its time, or max_age_ms after its time.
+	  Call it until it returns false, e.g. after every luminox_process_response() or from a timer.
+
+    @param[in] resampler Pointer of the resampler
+
+    @param[in] now Current time in milliseconds, on the clock of the samples
+
+    @param[out] row Filled in with the row if one is ready
+
+    @return true if a row was produced
+*/
+bool luminox_resample_poll(luminox_resampler_t * resampler, uint32_t now, luminox_resample_row_t * row);
+
+
+#endif // LUMINOX_RESAMPLE_H
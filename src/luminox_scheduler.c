@@ -0,0 +1,180 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Poll Scheduler
+
+  @File Name
+    luminox_scheduler.c
+
+  @Summary
+    Earliest-deadline-first poll scheduler for several LuminOx sensors
+
+  @Description
+    Implements functions that decide which of a set of LuminOx sensors to poll next
+******************************************************************************/
+
+
+#include <stdint.h>
+#include <stddef.h>
+#include "luminox.h"
+#include "luminox_scheduler.h"
+
+// the driver never allocates, any use of the heap is a compile error
+#if defined(__GNUC__)
+#pragma GCC poison malloc calloc realloc free
+#endif
+
+/*
+    @brief Function for comparing two times that may have wrapped around
+
+    @return true if time a is before time b
+*/
+static bool luminox_time_before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+/*
+    @brief Function for initializing a scheduler without any sensors
+
+    @param[in] scheduler Pointer of the scheduler
+*/
+void luminox_scheduler_init(luminox_scheduler_t * scheduler) {
+    scheduler->count = 0;
+    scheduler->misses = 0;
+}
+
+/*
+    @brief Function for adding a sensor to the scheduler
+
+    @note The first period of the sensor is released right away
+
+    @param[in] scheduler Pointer of the scheduler
+
+    @param[in] luminox_handler Handler of an initialized sensor
+
+    @param[in] period_ms Time between two polls of the sensor in milliseconds
+
+    @param[in] priority Priority of the sensor when deadlines are equal, higher goes first
+
+    @param[in] command Request to send every period
+
+    @param[in] now Current time in milliseconds
+
+    @return luminox_retcode_t Success, LUMINOX_ERR_FULL if LUMINOX_SCHEDULER_MAX_SENSORS are scheduled or
+			      LUMINOX_ERROR for a zero period
+*/
+luminox_retcode_t luminox_scheduler_add(luminox_scheduler_t * scheduler, luminox_handler_t * luminox_handler, uint32_t period_ms, uint8_t priority, luminox_command_t command, uint32_t now) {
+    if(period_ms == 0) {
+        return LUMINOX_ERROR;
+    }
+    if(scheduler->count >= LUMINOX_SCHEDULER_MAX_SENSORS) {
+        return LUMINOX_ERR_FULL;
+    }
+
+    luminox_schedule_entry_t * entry = &scheduler->entries[scheduler->count++];
+    entry->handler = luminox_handler;
+    entry->command = command;
+    entry->period_ms = period_ms;
+    entry->priority = priority;
+    entry->release = now;
+    entry->misses = 0;
+
+    return LUMINOX_SUCCESS;
+}
+
+/*
+    @brief Function for picking the sensor to poll next
+
+    @note Of the sensors whose period has been released, picks the one with the earliest deadline.
+	  Periods whose deadline already passed are counted as misses and skipped, so a late sensor
+	  is polled once for its current period instead of once for every period it missed.
+
+    @param[in] scheduler Pointer of the scheduler
+
+    @param[in] now Current time in milliseconds
+
+    @return Entry to poll, NULL if no sensor is due. Call luminox_scheduler_complete() once the command was sent.
+*/
+luminox_schedule_entry_t * luminox_scheduler_next(luminox_scheduler_t * scheduler, uint32_t now) {
+    luminox_schedule_entry_t * next = NULL;
+
+    for(uint8_t i = 0; i < scheduler->count; i++) {
+        luminox_schedule_entry_t * entry = &scheduler->entries[i];
+
+        // skip periods that ended without a poll, constant work however long the sensor was late
+        if(!luminox_time_before(now, entry->release + entry->period_ms)) {
+            uint32_t missed = (now - entry->release) / entry->period_ms;
+            entry->release += missed * entry->period_ms;
+            entry->misses += missed;
+            scheduler->misses += missed;
+        }
+        if(luminox_time_before(now, entry->release)) {
+            continue; // this period's poll is already done
+        }
+
+        if(next == NULL) {
+            next = entry;
+            continue;
+        }
+        uint32_t deadline = entry->release + entry->period_ms;
+        uint32_t next_deadline = next->release + next->period_ms;
+        if(luminox_time_before(deadline, next_deadline)
+            || (deadline == next_deadline && entry->priority > next->priority)) {
+            next = entry;
+        }
+    }
+
+    return next;
+}
+
+/*
+    @brief Function for marking the current period of an entry as done
+
+    @param[in] entry Entry returned by luminox_scheduler_next()
+*/
+void luminox_scheduler_complete(luminox_schedule_entry_t * entry) {
+    entry->release += entry->period_ms; // next poll is due when the next period starts
+}
+
+/*
+    @brief Function for polling the next sensor that is due
+
+    @note Combines luminox_scheduler_next(), luminox_request() and luminox_scheduler_complete().
+	  Call this function in your super loop.
+
+    @param[in] scheduler Pointer of the scheduler
+
+    @param[in] now Current time in milliseconds
+
+    @return luminox_retcode_t Result of the request, success if no sensor was due
+*/
+luminox_retcode_t luminox_scheduler_run(luminox_scheduler_t * scheduler, uint32_t now) {
+    luminox_schedule_entry_t * entry = luminox_scheduler_next(scheduler, now);
+    if(entry == NULL) {
+        return LUMINOX_SUCCESS;
+    }
+    luminox_retcode_t ret = luminox_request(entry->command, entry->handler);
+    luminox_scheduler_complete(entry);
+    return ret;
+}
+
+/*
+    @brief Function for getting the time until the next sensor is due
+
+    @param[in] scheduler Pointer of the scheduler
+
+    @param[in] now Current time in milliseconds
+
+    @return Milliseconds the micro can sleep, 0 if a sensor is due, UINT32_MAX without sensors
+*/
+uint32_t luminox_scheduler_idle_time(luminox_scheduler_t * scheduler, uint32_t now) {
+    uint32_t idle = UINT32_MAX;
+    for(uint8_t i = 0; i < scheduler->count; i++) {
+        const luminox_schedule_entry_t * entry = &scheduler->entries[i];
+        if(!luminox_time_before(now, entry->release)) {
+            return 0;
+        }
+        if(entry->release - now < idle) {
+            idle = entry->release - now;
+        }
+    }
+    return idle;
+}
@@ -0,0 +1,125 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Poll Scheduler
+
+  @File Name
+    luminox_scheduler.h
+
+  @Summary
+    Earliest-deadline-first poll scheduler for several LuminOx sensors
+
+  @Description
+    Defines functions that decide which of a set of LuminOx sensors to poll next
+******************************************************************************/
+
+#ifndef LUMINOX_SCHEDULER_H
+#define LUMINOX_SCHEDULER_H
+
+#include <stdint.h>
+#include "luminox.h"
+
+/*
+    Number of sensors one scheduler can poll, the entry table is statically allocated in luminox_scheduler_t
+*/
+#ifndef LUMINOX_SCHEDULER_MAX_SENSORS
+#define LUMINOX_SCHEDULER_MAX_SENSORS 16
+#endif
+#if LUMINOX_SCHEDULER_MAX_SENSORS > 255 || LUMINOX_SCHEDULER_MAX_SENSORS < 1
+#error "LUMINOX_SCHEDULER_MAX_SENSORS must be 1 to 255"
+#endif
+
+/*
+    One sensor polled by the scheduler. Every period the sensor must be sent its command once, before the
+    end of the period. Each period is released at release and has its deadline one period later.
+*/
+typedef struct {
+    luminox_handler_t * handler;
+    luminox_command_t command; // request sent every period, e.g. LUMINOX_COMMAND_ALL
+    uint32_t period_ms;
+    uint8_t priority; // breaks ties between equal deadlines, higher goes first
+    uint32_t release; // time the current period starts
+    uint32_t misses; // periods that ended before the command was sent
+} luminox_schedule_entry_t;
+
+// luminox scheduler struct
+typedef struct {
+    luminox_schedule_entry_t entries[LUMINOX_SCHEDULER_MAX_SENSORS];
+    uint8_t count;
+    uint32_t misses; // deadline misses of all entries
+} luminox_scheduler_t;
+
+/*
+    @brief Function for initializing a scheduler without any sensors
+
+    @param[in] scheduler Pointer of the scheduler
+*/
+void luminox_scheduler_init(luminox_scheduler_t * scheduler);
+
+/*
+    @brief Function for adding a sensor to the scheduler
+
+    @note The first period of the sensor is released right away
+
+    @param[in] luminox_handler Handler of an initialized sensor
+
+    @param[in] period_ms Time between two polls of the sensor in milliseconds
+
+    @param[in] priority Priority of the sensor when deadlines are equal, higher goes first
+
+    @param[in] command Request to send every period
+
+    @param[in] now Current time in milliseconds
+
+    @return luminox_retcode_t Success, LUMINOX_ERR_FULL if LUMINOX_SCHEDULER_MAX_SENSORS are scheduled or
+			      LUMINOX_ERROR for a zero period
+*/
+luminox_retcode_t luminox_scheduler_add(luminox_scheduler_t * scheduler, luminox_handler_t * luminox_handler, uint32_t period_ms, uint8_t priority, luminox_command_t command, uint32_t now);
+
+/*
+    @brief Function for picking the sensor to poll next
+
+    @note Of the sensors whose period has been released, picks the one with the earliest deadline.
+	  Periods whose deadline already passed are counted as misses and skipped, so a late sensor
+	  is polled once for its current period instead of once for every period it missed.
+
+    @param[in] scheduler Pointer of the scheduler
+
+    @param[in] now Current time in milliseconds
+
+    @return Entry to poll, NULL if no sensor is due. Call luminox_scheduler_complete() once the command was sent.
+*/
+luminox_schedule_entry_t * luminox_scheduler_next(luminox_scheduler_t * scheduler, uint32_t now);
+
+/*
+    @brief Function for marking the current period of an entry as done
+
+    @param[in] entry Entry returned by luminox_scheduler_next()
+*/
+void luminox_scheduler_complete(luminox_schedule_entry_t * entry);
+
+/*
+    @brief Function for polling the next sensor that is due
+
+    @note Combines luminox_scheduler_next(), luminox_request() and luminox_scheduler_complete().
+	  Call this function in your super loop.
+
+    @param[in] scheduler Pointer of the scheduler
+
+    @param[in] now Current time in milliseconds
+
+    @return luminox_retcode_t Result of the request, success if no sensor was due
+*/
+luminox_retcode_t luminox_scheduler_run(luminox_scheduler_t * scheduler, uint32_t now);
+
+/*
+    @brief Function for getting the time until the next sensor is due
+
+    @param[in] scheduler Pointer of the scheduler
+
+    @param[in] now Current time in milliseconds
+
+    @return Milliseconds the micro can sleep, 0 if a sensor is due, UINT32_MAX without sensors
+*/
+uint32_t luminox_scheduler_idle_time(luminox_scheduler_t * scheduler, uint32_t now);
+
+
+#endif // LUMINOX_SCHEDULER_H
@@ -0,0 +1,199 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Passive Sniffer
+
+  @File Name
+    luminox_sniffer.c
+
+  @Summary
+    Passive decoder of a tapped link between another controller and a LuminOx sensor
+
+  @Description
+    Implements functions that decode the commands and responses seen on the TX and RX lines of a
+    LuminOx link the driver doesn't control, pair them and measure the sensor's response latency
+******************************************************************************/
+
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "luminox.h"
+#include "luminox_sniffer.h"
+
+// the driver never allocates, any use of the heap is a compile error
+#if defined(__GNUC__)
+#pragma GCC poison malloc calloc realloc free
+#endif
+
+/*
+    @brief Function for initializing a sniffer
+
+    @note The handler must be zero initialized and not passed to luminox_init(), which would transmit.
+	  The sniffer uses the timestamps given with the bytes instead of luminox_get_time.
+
+    @param[in] sniffer Pointer of the sniffer
+
+    @param[in] luminox_handler Handler that decodes the responses of the link
+
+    @param[in] callback Function to call for every response, may be NULL
+
+    @param[in] context Passed back to callback untouched
+*/
+void luminox_sniffer_init(luminox_sniffer_t * sniffer, luminox_handler_t * luminox_handler, luminox_sniffer_cb_t callback, void * context) {
+    memset(sniffer, 0, sizeof(luminox_sniffer_t));
+    sniffer->handler = luminox_handler;
+    sniffer->callback = callback;
+    sniffer->context = context;
+}
+
+/*
+    @brief Function for decoding a complete command
+
+    @note Tells the handler which information a "# x" command asks for, the response doesn't say
+
+    @param[in] sniffer Pointer of the sniffer
+
+    @param[in] size Size of the command without the terminator
+
+    @param[in] timestamp Time the terminator was seen
+*/
+static void luminox_sniffer_command(luminox_sniffer_t * sniffer, uint8_t size, uint32_t timestamp) {
+    luminox_handler_t * luminox_handler = sniffer->handler;
+    uint8_t command = sniffer->command[0];
+    uint8_t argument = (size >= 3 && sniffer->command[1] == SEPARATOR) ? sniffer->command[2] : 0;
+
+    switch(command) {
+        case MODE_OUTPUT:
+        case SENSOR_INFORMATION:
+            if(argument < '0' || argument > '2') {
+                return; // not a LuminOx command
+            }
+            break;
+        case PPO2:
+        case O2:
+        case TEMPERATURE:
+        case BAROMETRIC_PRESSURE:
+        case ALL:
+        case SENSOR_STATUS:
+            break;
+        default:
+            return; // not a LuminOx command
+    }
+
+    if(sniffer->command_pending) {
+        sniffer->unanswered++;
+    }
+    if(command == SENSOR_INFORMATION) {
+        luminox_handler->pending_info = (luminox_sensor_info_t)(argument - '0');
+    }
+    sniffer->exchange.command = command;
+    sniffer->exchange.argument = argument;
+    sniffer->exchange.command_time = timestamp;
+    sniffer->command_pending = true;
+
+    // the handler measures the latency of the exchange too
+    luminox_handler->request_time = timestamp;
+    luminox_handler->request_pending = true;
+}
+
+/*
+    @brief Function for feeding a byte seen on the command line (controller to sensor)
+
+    @param[in] sniffer Pointer of the sniffer
+
+    @param[in] byte Byte seen on the line
+
+    @param[in] timestamp Time the byte was seen in milliseconds
+*/
+void luminox_sniffer_command_byte(luminox_sniffer_t * sniffer, uint8_t byte, uint32_t timestamp) {
+    if(byte == TERMINATOR) {
+        uint8_t size = sniffer->command_index;
+        sniffer->command_index = 0;
+        if(size > 0 && size < LUMINOX_SNIFFER_COMMAND_SIZE) {
+            if(sniffer->command[size - 1] == '\r') {
+                size--;
+            }
+            if(size > 0) {
+                luminox_sniffer_command(sniffer, size, timestamp);
+            }
+        }
+        return;
+    }
+    if(sniffer->command_index < LUMINOX_SNIFFER_COMMAND_SIZE) {
+        sniffer->command[sniffer->command_index++] = byte; // stays at the size while dropping a long line
+    }
+}
+
+/*
+    @brief Function for checking that a response answers a command
+
+    @note An error response answers any command, "A" is answered by "O ..." and every other command by a response
+	  starting with the same character
+
+    @param[in] command Command character of the pending command
+
+    @param[in] response First byte of the response
+
+    @return true if the response answers the command
+*/
+static bool luminox_sniffer_answers(uint8_t command, uint8_t response) {
+    if(response == ERROR_RESPONSE) {
+        return true;
+    }
+    return response == ((command == ALL) ? PPO2 : command);
+}
+
+/*
+    @brief Function for feeding a byte seen on the response line (sensor to controller)
+
+    @note Decodes the response once its terminator arrives and calls the callback. The response is paired with the
+	  pending command only if it answers it, any other response (e.g. streamed in between) is unsolicited and the
+	  command stays pending.
+
+    @param[in] sniffer Pointer of the sniffer
+
+    @param[in] byte Byte seen on the line
+
+    @param[in] timestamp Time the byte was seen in milliseconds
+
+    @return true if the byte completed a response
+*/
+bool luminox_sniffer_response_byte(luminox_sniffer_t * sniffer, uint8_t byte, uint32_t timestamp) {
+    luminox_handler_t * luminox_handler = sniffer->handler;
+    luminox_sniffer_exchange_t * exchange = &sniffer->exchange;
+    luminox_sniffer_exchange_t unsolicited = { 0 }; // no command, argument or latency
+
+    // the handler's clock follows the tap, as in luminox_replay()
+    luminox_handler->replay_active = true;
+    luminox_handler->virtual_time = timestamp;
+    if(!luminox_receive_byte(byte, luminox_handler)) {
+        luminox_handler->replay_active = false;
+        return false;
+    }
+    uint8_t first = (luminox_handler->luminox_data_size > 0) ? luminox_handler->luminox_data[0] : 0;
+    bool answers = sniffer->command_pending && luminox_sniffer_answers(exchange->command, first);
+    bool request_pending = luminox_handler->request_pending;
+    luminox_handler->request_pending = answers; // only the answer ends the handler's latency measurement
+    luminox_process_response(luminox_handler);
+    luminox_handler->request_pending = answers ? false : request_pending;
+    luminox_handler->replay_active = false;
+
+    if(answers) {
+        exchange->latency = timestamp - exchange->command_time;
+        if(exchange->latency > sniffer->max_latency) {
+            sniffer->max_latency = exchange->latency;
+        }
+        sniffer->exchanges++;
+        sniffer->command_pending = false;
+    } else {
+        exchange = &unsolicited; // keeps a pending command waiting for its own response
+        sniffer->unsolicited++;
+    }
+    exchange->response_time = timestamp;
+    exchange->err_code = luminox_handler->err_code;
+    exchange->sample = &luminox_handler->sample;
+
+    if(sniffer->callback != NULL) {
+        sniffer->callback(exchange, sniffer->context);
+    }
+    return true;
+}
@@ -0,0 +1,110 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Passive Sniffer
+
+  @File Name
+    luminox_sniffer.h
+
+  @Summary
+    Passive decoder of a tapped link between another controller and a LuminOx sensor
+
+  @Description
+    Defines functions that decode the commands and responses seen on the TX and RX lines of a
+    LuminOx link the driver doesn't control, pair them and measure the sensor's response latency
+******************************************************************************/
+
+#ifndef LUMINOX_SNIFFER_H
+#define LUMINOX_SNIFFER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "luminox.h"
+
+/*
+    Longest command the sniffer keeps, the longest LuminOx command is "M x\r\n".
+    Longer lines on the command stream are not LuminOx commands and are dropped.
+*/
+#ifndef LUMINOX_SNIFFER_COMMAND_SIZE
+#define LUMINOX_SNIFFER_COMMAND_SIZE 8
+#endif
+#if LUMINOX_SNIFFER_COMMAND_SIZE > 255 || LUMINOX_SNIFFER_COMMAND_SIZE < 3
+#error "LUMINOX_SNIFFER_COMMAND_SIZE must be 3 to 255"
+#endif
+
+// @brief one decoded response and the command it answers
+typedef struct {
+    uint8_t command; // command character, e.g. ALL or MODE_OUTPUT, 0 for a response nobody asked for (streaming mode)
+    uint8_t argument; // argument character of "M x" and "# x", 0 if the command has none
+    uint32_t command_time; // time the command's terminator was seen
+    uint32_t response_time; // time the response's terminator was seen
+    uint32_t latency; // response_time - command_time, 0 without a command
+    luminox_retcode_t err_code; // outcome of decoding the response
+    const luminox_sample_t * sample; // measurements decoded from the response
+} luminox_sniffer_exchange_t;
+
+typedef void (*luminox_sniffer_cb_t)(const luminox_sniffer_exchange_t * exchange, void * context);
+
+/*
+    luminox sniffer struct, one per tapped link.
+    The handler decodes the responses with the normal parser, so its subscribers, history and identity
+    work as usual. Its luminox_tx is never called.
+*/
+typedef struct {
+    luminox_handler_t * handler;
+    uint8_t command[LUMINOX_SNIFFER_COMMAND_SIZE]; // command being received
+    uint8_t command_index; // number of bytes in command, LUMINOX_SNIFFER_COMMAND_SIZE while dropping a long line
+    luminox_sniffer_exchange_t exchange; // command waiting for its response
+    bool command_pending; // exchange holds a command that wasn't answered yet
+    uint32_t exchanges; // responses paired with a command
+    uint32_t unanswered; // commands followed by another command instead of a response
+    uint32_t unsolicited; // responses without a command
+    uint32_t max_latency; // longest latency of a paired response
+    luminox_sniffer_cb_t callback; // optional, called for every response, NULL if unused
+    void * context; // passed back to callback untouched
+} luminox_sniffer_t;
+
+/*
+    @brief Function for initializing a sniffer
+
+    @note The handler must be zero initialized and not passed to luminox_init(), which would transmit.
+	  The sniffer uses the timestamps given with the bytes instead of luminox_get_time.
+
+    @param[in] sniffer Pointer of the sniffer
+
+    @param[in] luminox_handler Handler that decodes the responses of the link
+
+    @param[in] callback Function to call for every response, may be NULL
+
+    @param[in] context Passed back to callback untouched
+*/
+void luminox_sniffer_init(luminox_sniffer_t * sniffer, luminox_handler_t * luminox_handler, luminox_sniffer_cb_t callback, void * context);
+
+/*
+    @brief Function for feeding a byte seen on the command line (controller to sensor)
+
+    @param[in] sniffer Pointer of the sniffer
+
+    @param[in] byte Byte seen on the line
+
+    @param[in] timestamp Time the byte was seen in milliseconds
+*/
+void luminox_sniffer_command_byte(luminox_sniffer_t * sniffer, uint8_t byte, uint32_t timestamp);
+
+/*
+    @brief Function for feeding a byte seen on the response line (sensor to controller)
+
+    @note Decodes the response once its terminator arrives and calls the callback. The response is paired with the
+	  pending command only if it answers it, any other response (e.g. streamed in between) is unsolicited and the
+	  command stays pending.
+
+    @param[in] sniffer Pointer of the sniffer
+
+    @param[in] byte Byte seen on the line
+
+    @param[in] timestamp Time the byte was seen in milliseconds
+
+    @return true if the byte completed a response
+*/
+bool luminox_sniffer_response_byte(luminox_sniffer_t * sniffer, uint8_t byte, uint32_t timestamp);
+
+
+#endif // LUMINOX_SNIFFER_H
@@ -0,0 +1,296 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Allocation Check
+
+  @File Name
+    luminox_alloc_check.c
+
+  @Summary
+    Checks that no driver module allocates from the heap at run time
+
+  @Description
+    The driver sources poison malloc and friends, which only catches direct calls. This check replaces malloc,
+    calloc, realloc and free for the whole process, so allocations made on the driver's behalf by the C library,
+    e.g. from snprintf(), are counted too. Drives every module against a simulated sensor with the counters armed
+    and fails if anything was allocated or freed.
+      cc -O2 -DLUMINOX_PROFILING -DLUMINOX_ROLLUPS -DLUMINOX_HISTORY -I../src luminox_alloc_check.c ../src/luminox*.c -o luminox_alloc_check
+      ./luminox_alloc_check
+******************************************************************************/
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "luminox.h"
+#include "luminox_fleet.h"
+#include "luminox_query.h"
+#include "luminox_resample.h"
+#include "luminox_scheduler.h"
+#include "luminox_sniffer.h"
+
+#ifndef LUMINOX_PROFILING
+#error "build the allocation check with -DLUMINOX_PROFILING"
+#endif
+#ifndef LUMINOX_ROLLUPS
+#error "build the allocation check with -DLUMINOX_ROLLUPS"
+#endif
+#ifndef LUMINOX_HISTORY
+#error "build the allocation check with -DLUMINOX_HISTORY"
+#endif
+
+#define LUMINOX_CHECK_POLLS 200
+
+volatile bool luminox_complete_uart_rx; // only used by the blocking luminox_wait_for_response()
+
+// glibc's own allocator, which the replacements below forward to
+extern void * __libc_malloc(size_t size);
+extern void * __libc_calloc(size_t count, size_t size);
+extern void * __libc_realloc(void * pointer, size_t size);
+extern void __libc_free(void * pointer);
+
+static volatile bool armed; // only count while the driver runs, stdio may allocate its buffers
+static volatile unsigned long allocations;
+static volatile unsigned long releases;
+
+void * malloc(size_t size) {
+    allocations += armed;
+    return __libc_malloc(size);
+}
+
+void * calloc(size_t count, size_t size) {
+    allocations += armed;
+    return __libc_calloc(count, size);
+}
+
+void * realloc(void * pointer, size_t size) {
+    allocations += armed;
+    return __libc_realloc(pointer, size);
+}
+
+void free(void * pointer) {
+    releases += armed && (pointer != NULL);
+    __libc_free(pointer);
+}
+
+static luminox_handler_t sensors[2];
+static luminox_handler_t * current_sensor; // handler calling luminox_tx, it has no context argument
+static luminox_handler_t sniffed;
+static luminox_fleet_t fleet;
+static luminox_resampler_t resampler;
+static luminox_scheduler_t scheduler;
+static luminox_sniffer_t sniffer;
+static luminox_sample_t batch[8];
+static luminox_capture_record_t records[64];
+static uint8_t pool[2048];
+static uint32_t record_count;
+static uint32_t pool_used;
+static uint32_t virtual_time;
+static uint32_t delivered;
+
+// the simulated sensor answers every request at once, like a blocking uart_write() that waits for the response
+static int luminox_check_response(const unsigned char * request, char * response, size_t size) {
+    float ppo2 = 213.0f + (float)(virtual_time / 1000 % 7);
+    switch(request[0]) {
+        case MODE_OUTPUT:
+            return snprintf(response, size, "M 0%c\r\n", request[2]);
+        case SENSOR_INFORMATION:
+            return snprintf(response, size, (request[2] == '0') ? "# 02024 00123\r\n"
+                                            : (request[2] == '1') ? "# 00012 34567\r\n" : "# 00004\r\n");
+        case PPO2:
+            return snprintf(response, size, "O %06.1f\r\n", ppo2);
+        case O2:
+            return snprintf(response, size, "%% %06.2f\r\n", ppo2 / 10.13f);
+        case TEMPERATURE:
+            return snprintf(response, size, "T +21.3\r\n");
+        case BAROMETRIC_PRESSURE:
+            return snprintf(response, size, "P 1013\r\n");
+        case SENSOR_STATUS:
+            return snprintf(response, size, "e 0000\r\n");
+        default:
+            return snprintf(response, size, "O %06.1f T +21.3 P 1013 %% %06.2f e 0000\r\n", ppo2, ppo2 / 10.13f);
+    }
+}
+
+static void luminox_check_tx(unsigned char * request, uint8_t size) {
+    char response[64];
+    int length = luminox_check_response(request, response, sizeof(response));
+    virtual_time += (uint32_t)((size + length) * LUMINOX_BITS_PER_BYTE * 1000 / LUMINOX_BAUDRATE) + 5;
+    luminox_update_data((uint8_t *)response, (uint8_t)length, current_sensor);
+}
+
+static uint32_t luminox_check_time(void) {
+    return virtual_time;
+}
+
+static uint32_t luminox_check_cycles(void) {
+    return virtual_time;
+}
+
+static void luminox_check_capture(const luminox_capture_record_t * record, void * context) {
+    (void)context;
+    if(record_count < sizeof(records) / sizeof(records[0]) && pool_used + record->size <= sizeof(pool)) {
+        memcpy(&pool[pool_used], record->data, record->size);
+        records[record_count] = *record;
+        records[record_count++].data = &pool[pool_used];
+        pool_used += record->size;
+    }
+}
+
+static void luminox_check_trace(luminox_trace_event_t event, void * context) {
+    (void)context;
+    (void)luminox_trace_event_name(event);
+    (void)luminox_trace_event_phase(event);
+}
+
+static void luminox_check_subscriber(const luminox_sample_t * sample, void * context) {
+    (void)sample;
+    (void)context;
+    delivered++;
+}
+
+static void luminox_check_batch(const luminox_sample_t * samples, uint16_t count, void * context) {
+    (void)samples;
+    (void)context;
+    delivered += count;
+}
+
+static void luminox_check_sniffed(const luminox_sniffer_exchange_t * exchange, void * context) {
+    (void)exchange;
+    (void)context;
+    delivered++;
+}
+
+static void luminox_check_sniff(const char * command, const char * response) {
+    for(size_t i = 0; command[i] != '\0'; i++) {
+        luminox_sniffer_command_byte(&sniffer, (uint8_t)command[i], virtual_time);
+    }
+    virtual_time += 50;
+    for(size_t i = 0; response[i] != '\0'; i++) {
+        luminox_sniffer_response_byte(&sniffer, (uint8_t)response[i], virtual_time);
+    }
+}
+
+static void luminox_check_modules(void) {
+    float value;
+    uint16_t size;
+    uint8_t blob[LUMINOX_CALIBRATION_BLOB_HEADER_SIZE + LUMINOX_CALIBRATION_BLOB_ENTRY_SIZE];
+    uint8_t query[2] = { LUMINOX_QUERY_SNAPSHOT, 0 };
+    uint8_t response[512];
+    char metrics[1024];
+    luminox_resample_row_t row;
+    luminox_history_segment_t segments[2];
+    luminox_bus_stats_t stats;
+    const luminox_compensation_point_t curve[] = { { 0, 65536 }, { 4000, 66847 } };
+
+    // blocking and non-blocking bring-up
+    current_sensor = &sensors[0];
+    luminox_init(&sensors[0]);
+    current_sensor = &sensors[1];
+    luminox_init_start(&sensors[1]);
+    while(luminox_sequence_busy(&sensors[1])) {
+        luminox_process_response(&sensors[1]); // the response is already there, it sends the next request
+    }
+    luminox_probe_start(&sensors[1]);
+    while(luminox_sequence_busy(&sensors[1])) {
+        luminox_process_response(&sensors[1]);
+    }
+    (void)luminox_sequence_result(&sensors[1]);
+
+    // per sample processing
+    current_sensor = &sensors[0];
+    luminox_subscribe(luminox_check_subscriber, NULL, LUMINOX_FIELD_ALL, &sensors[0]);
+    luminox_set_batch(batch, sizeof(batch) / sizeof(batch[0]), 2000, luminox_check_batch, NULL, &sensors[0]);
+    luminox_set_deadband(LUMINOX_FIELD_PPO2, 1.0f, 0.0f, 10000, &sensors[0]);
+    luminox_set_spike_filter(LUMINOX_FIELD_PPO2, 50.0f, 3, &sensors[0]);
+    luminox_track_quantile(LUMINOX_FIELD_PPO2, 0.99f, &sensors[0]);
+    luminox_set_temp_compensation(curve, sizeof(curve) / sizeof(curve[0]), &sensors[0]);
+    luminox_set_external_pressure(1013.0f, &sensors[0]);
+    luminox_fleet_init(&fleet);
+    luminox_fleet_add(&fleet, &sensors[0], NULL);
+    luminox_fleet_add(&fleet, &sensors[1], NULL);
+    luminox_resample_init(&resampler, LUMINOX_FIELD_PPO2, LUMINOX_RESAMPLE_LINEAR, 1000, 3000);
+    luminox_resample_add(&resampler, &sensors[0], NULL);
+    luminox_resample_add(&resampler, &sensors[1], NULL);
+    luminox_scheduler_init(&scheduler);
+    luminox_scheduler_add(&scheduler, &sensors[0], 1000, 0, LUMINOX_COMMAND_ALL, virtual_time);
+    luminox_scheduler_add(&scheduler, &sensors[1], 2500, 1, LUMINOX_COMMAND_PPO2, virtual_time);
+    for(uint32_t i = 0; i < LUMINOX_CHECK_POLLS; i++) {
+        virtual_time += 500;
+        luminox_schedule_entry_t * entry = luminox_scheduler_next(&scheduler, virtual_time);
+        if(entry != NULL) {
+            current_sensor = entry->handler;
+            luminox_request(entry->command, entry->handler);
+            luminox_scheduler_complete(entry);
+        }
+        (void)luminox_scheduler_idle_time(&scheduler, virtual_time);
+        current_sensor = &sensors[i % 2];
+        luminox_request((luminox_command_t)(i % (LUMINOX_COMMAND_SENSOR_STATUS + 1)), current_sensor);
+        luminox_poll_batch(&sensors[0]);
+        while(luminox_resample_poll(&resampler, virtual_time, &row)) {
+        }
+        (void)luminox_fleet_any_below(&fleet, LUMINOX_FIELD_PPO2, 160.0f);
+        (void)luminox_fleet_count_below(&fleet, LUMINOX_FIELD_O2, 19.5f);
+        (void)luminox_fleet_column(&fleet, LUMINOX_FIELD_TEMP);
+    }
+    current_sensor = &sensors[0];
+    luminox_scheduler_init(&scheduler); // luminox_scheduler_run() can't tell luminox_tx which handler sends
+    luminox_scheduler_add(&scheduler, &sensors[0], 1000, 0, LUMINOX_COMMAND_ALL, virtual_time);
+    for(uint32_t i = 0; i < 4; i++) {
+        virtual_time += 1000;
+        luminox_scheduler_run(&scheduler, virtual_time);
+    }
+    luminox_flush_batch(&sensors[0]);
+    luminox_get_quantile(LUMINOX_FIELD_PPO2, 0.99f, &value, &sensors[0]);
+    luminox_reset_quantiles(&sensors[0]);
+    (void)luminox_get_spike_filter(LUMINOX_FIELD_PPO2, &sensors[0]);
+    luminox_get_derived_O2(&value, &sensors[0]);
+    luminox_history_segments(luminox_get_history(&sensors[0]), segments);
+    (void)luminox_get_rollup(LUMINOX_ROLLUP_MINUTE, 0, &sensors[0]);
+    (void)luminox_rollup_count(LUMINOX_ROLLUP_MINUTE, &sensors[0]);
+    luminox_get_bus_stats(&stats, &sensors[0]);
+    (void)luminox_get_profile(LUMINOX_PROFILE_PROCESS_RESPONSE, &sensors[0]);
+    luminox_reset_profile(&sensors[0]);
+    luminox_unsubscribe(luminox_check_subscriber, NULL, &sensors[0]);
+
+    // calibration, queries and metrics
+    luminox_save_calibration(blob, sizeof(blob), &size, &sensors[0]);
+    luminox_load_calibration(blob, size, &sensors[1]);
+    for(uint8_t opcode = LUMINOX_QUERY_SNAPSHOT; opcode <= LUMINOX_QUERY_IDENTITY; opcode++) {
+        query[0] = opcode;
+        luminox_query_handle(query, sizeof(query), response, sizeof(response), &size, &sensors[0]);
+    }
+    luminox_query_metrics(metrics, sizeof(metrics), &sensors[0]);
+
+    // record and replay
+    luminox_replay(records, record_count, &sensors[1]);
+
+    // passive listening
+    luminox_sniffer_init(&sniffer, &sniffed, luminox_check_sniffed, NULL);
+    luminox_check_sniff("A\r\n", "O 0213.0 T +21.3 P 1013 % 021.03 e 0000\r\n");
+    luminox_check_sniff("M 1\r\n", "M 01\r\n");
+    luminox_check_sniff("X\r\n", "E 01\r\n");
+    luminox_check_sniff("", "O 0212.0 T +21.3 P 1013 % 020.93 e 0000\r\n");
+}
+
+int main(void) {
+    for(size_t i = 0; i < sizeof(sensors) / sizeof(sensors[0]); i++) {
+        sensors[i].luminox_tx = luminox_check_tx;
+        sensors[i].luminox_get_time = luminox_check_time;
+        sensors[i].luminox_get_cycles = luminox_check_cycles;
+        sensors[i].luminox_trace = luminox_check_trace;
+    }
+    sensors[0].luminox_capture = luminox_check_capture;
+    sniffed.luminox_get_time = luminox_check_time;
+    sniffed.luminox_get_cycles = luminox_check_cycles;
+
+    armed = true;
+    luminox_check_modules();
+    armed = false;
+
+    printf("%lu samples delivered, %u records replayed, %lu allocations, %lu frees\n", (unsigned long)delivered,
+           record_count, allocations, releases);
+    if(delivered == 0 || record_count == 0) {
+        printf("the modules were not exercised\n");
+        return 1;
+    }
+    return (allocations > 0 || releases > 0) ? 1 : 0;
+}
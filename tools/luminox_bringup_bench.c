@@ -0,0 +1,139 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Bring-Up Benchmark
+
+  @File Name
+    luminox_bringup_bench.c
+
+  @Summary
+    Compares bringing up simulated sensors one after another and all at once
+
+  @Description
+    Simulates LuminOx sensors on separate 9600 baud links under a virtual millisecond clock. Every request is
+    answered after the request and the response took their time on the line plus a processing delay. Brings the
+    sensors up one after another, as with luminox_init(), and all at once with luminox_init_start(), and exits
+    with 1 if the concurrent bring-up of all sensors takes more than twice as long as one sensor.
+      cc -std=c99 -O2 -I../src luminox_bringup_bench.c ../src/luminox.c -o luminox_bringup_bench
+      ./luminox_bringup_bench [sensors, default 32]
+******************************************************************************/
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "luminox.h"
+
+#define LUMINOX_BENCH_MAX_SENSORS 256
+#define LUMINOX_BENCH_PROCESSING_MS 20 // time the simulated sensor takes to answer a request
+
+volatile bool luminox_complete_uart_rx; // only used by the blocking luminox_wait_for_response()
+
+typedef struct {
+    luminox_handler_t luminox;
+    char response[64]; // response on its way, empty if none
+    uint32_t response_time; // virtual time its last byte arrives
+} luminox_bench_sensor_t;
+
+static luminox_bench_sensor_t sensors[LUMINOX_BENCH_MAX_SENSORS];
+static luminox_bench_sensor_t * current_sensor; // sensor whose handler is calling luminox_tx
+static uint32_t virtual_time;
+
+static uint32_t luminox_bench_line_ms(size_t bytes) {
+    return (uint32_t)((bytes * LUMINOX_BITS_PER_BYTE * 1000 + LUMINOX_BAUDRATE - 1) / LUMINOX_BAUDRATE);
+}
+
+// luminox_tx has no context argument, so current_sensor is set before every call into the driver
+static void luminox_bench_tx(unsigned char * request, uint8_t size) {
+    luminox_bench_sensor_t * sensor = current_sensor;
+    switch(request[0]) {
+        case MODE_OUTPUT:
+            snprintf(sensor->response, sizeof(sensor->response), "M 0%c\r\n", request[2]);
+            break;
+        case SENSOR_INFORMATION:
+            snprintf(sensor->response, sizeof(sensor->response), "# %05u %05u\r\n", (unsigned)(sensor - sensors), 123u);
+            break;
+        case BAROMETRIC_PRESSURE:
+            snprintf(sensor->response, sizeof(sensor->response), "P 1013\r\n");
+            break;
+        default:
+            snprintf(sensor->response, sizeof(sensor->response), "O 0213.0 T +21.3 P 1013 %% 020.92 e 0000\r\n");
+            break;
+    }
+    sensor->response_time = virtual_time + luminox_bench_line_ms(size) + LUMINOX_BENCH_PROCESSING_MS
+                            + luminox_bench_line_ms(strlen(sensor->response));
+}
+
+static uint32_t luminox_bench_time(void) {
+    return virtual_time;
+}
+
+/*
+    @brief Function for bringing up sensors first to last with luminox_init_start(), all at once or one at a time
+
+    @return Virtual milliseconds until every sensor was initialized, 0 if one of them failed
+*/
+static uint32_t luminox_bench_bring_up(int first, int last, bool concurrent) {
+    uint32_t start = virtual_time;
+    int next = first; // next sensor to start
+    bool busy = true;
+    while(busy) {
+        busy = false;
+        for(int i = first; i < last; i++) {
+            luminox_bench_sensor_t * sensor = &sensors[i];
+            current_sensor = sensor;
+            if(sensor->response[0] != '\0' && sensor->response_time <= virtual_time) {
+                char response[sizeof(sensor->response)];
+                memcpy(response, sensor->response, sizeof(response));
+                sensor->response[0] = '\0'; // the next request may queue another response
+                for(size_t k = 0; response[k] != '\0'; k++) {
+                    if(luminox_receive_byte((uint8_t)response[k], &sensor->luminox)) {
+                        luminox_process_response(&sensor->luminox);
+                    }
+                }
+            }
+            if(luminox_sequence_busy(&sensor->luminox)) {
+                busy = true;
+            }
+        }
+        if(next < last && (concurrent || !busy)) {
+            do {
+                current_sensor = &sensors[next];
+                luminox_init_start(&sensors[next].luminox);
+                next++;
+            } while(concurrent && next < last);
+            busy = true;
+        }
+        if(busy) {
+            virtual_time++;
+        }
+    }
+    for(int i = first; i < last; i++) {
+        if(luminox_sequence_result(&sensors[i].luminox) != LUMINOX_SUCCESS) {
+            return 0;
+        }
+    }
+    return virtual_time - start;
+}
+
+int main(int argc, char ** argv) {
+    int count = (argc > 1) ? atoi(argv[1]) : 32;
+    if(count < 1 || count > LUMINOX_BENCH_MAX_SENSORS / 2) {
+        fprintf(stderr, "sensors must be 1 to %d\n", LUMINOX_BENCH_MAX_SENSORS / 2);
+        return 1;
+    }
+    for(int i = 0; i < 2 * count; i++) {
+        sensors[i].luminox.luminox_tx = luminox_bench_tx;
+        sensors[i].luminox.luminox_get_time = luminox_bench_time;
+    }
+
+    uint32_t one = luminox_bench_bring_up(0, 1, false);
+    uint32_t sequential = luminox_bench_bring_up(0, count, false);
+    uint32_t concurrent = luminox_bench_bring_up(count, 2 * count, true);
+    if(one == 0 || sequential == 0 || concurrent == 0) {
+        fprintf(stderr, "a simulated sensor failed to initialize\n");
+        return 1;
+    }
+    printf("1 sensor: %u ms\n%d sensors one after another: %u ms\n%d sensors at once: %u ms\n",
+           one, count, sequential, count, concurrent);
+    return (concurrent > 2 * one) ? 1 : 0;
+}
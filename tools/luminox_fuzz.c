@@ -0,0 +1,91 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Parser Fuzz Target
+
+  @File Name
+    luminox_fuzz.c
+
+  @Summary
+    Coverage guided fuzz target for the LuminOx response parser
+
+  @Description
+    Feeds every input through luminox_update_data() and, byte by byte, through luminox_receive_byte(),
+    calling luminox_process_response() on each like the firmware does. Build with
+      clang -fsanitize=fuzzer,address,undefined -I../src luminox_fuzz.c ../src/luminox.c
+    or, without libFuzzer, add -DLUMINOX_FUZZ_MAIN to run the files named on the command line once.
+******************************************************************************/
+
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "luminox.h"
+
+volatile bool luminox_complete_uart_rx; // only used by the blocking luminox_wait_for_response()
+
+static uint32_t luminox_fuzz_clock;
+
+static void luminox_fuzz_tx(unsigned char * request, uint8_t size) {
+    (void)request;
+    (void)size;
+}
+
+static uint32_t luminox_fuzz_time(void) {
+    return luminox_fuzz_clock++;
+}
+
+/*
+    @brief Function for checking what every decoded response must satisfy, aborts so the fuzzer keeps the input
+*/
+static void luminox_fuzz_check(const luminox_handler_t * luminox_handler) {
+    if(luminox_handler->luminox_data_size > UART_RX_BUF_SIZE) {
+        abort();
+    }
+#ifdef LUMINOX_HISTORY
+    if(luminox_handler->history.count > LUMINOX_HISTORY_SIZE || luminox_handler->history.head >= LUMINOX_HISTORY_SIZE) {
+        abort();
+    }
+#endif
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size) {
+    static luminox_handler_t luminox_handler;
+    luminox_handler.luminox_tx = luminox_fuzz_tx;
+    luminox_handler.luminox_get_time = luminox_fuzz_time;
+
+    // whole frames, as from a DMA or idle line interrupt
+    uint8_t frame[UART_RX_BUF_SIZE + 1]; // one byte more than fits, exercises the clamp
+    size_t frame_size = (size < sizeof(frame)) ? size : sizeof(frame);
+    for(size_t i = 0; i < frame_size; i++) {
+        frame[i] = data[i];
+    }
+    luminox_update_data(frame, (uint8_t)frame_size, &luminox_handler);
+    luminox_process_response(&luminox_handler);
+    luminox_fuzz_check(&luminox_handler);
+
+    // the same bytes one at a time, as from a receive interrupt
+    for(size_t i = 0; i < size; i++) {
+        if(luminox_receive_byte(data[i], &luminox_handler)) {
+            luminox_process_response(&luminox_handler);
+            luminox_fuzz_check(&luminox_handler);
+        }
+    }
+    return 0;
+}
+
+#ifdef LUMINOX_FUZZ_MAIN
+int main(int argc, char ** argv) {
+    static uint8_t input[4096];
+    for(int i = 1; i < argc; i++) {
+        FILE * file = fopen(argv[i], "rb");
+        if(file == NULL) {
+            perror(argv[i]);
+            return 1;
+        }
+        size_t size = fread(input, 1, sizeof(input), file);
+        fclose(file);
+        LLVMFuzzerTestOneInput(input, size);
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,133 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Parser Timing Harness
+
+  @File Name
+    luminox_parse_timing.c
+
+  @Summary
+    Worst case cost per received byte of luminox_process_response()
+
+  @Description
+    Times luminox_process_response() with LUMINOX_PROFILING over valid frames and adversarial inputs (no
+    terminator, field letters without arguments, placeholders, long digit runs, random bytes) and reports the
+    largest cost per input byte in cycles, counted with rdtsc on x86 and in nanoseconds elsewhere. Each input is
+    timed LUMINOX_TIMING_REPEATS times and the LUMINOX_TIMING_PERCENTILE of the runs kept, so slow runs count but
+    the few that were preempted don't. Exits with 1 if the worst input exceeds the bound given in cycles per byte.
+      cc -O2 -DLUMINOX_PROFILING -I../src luminox_parse_timing.c ../src/luminox.c -o luminox_parse_timing
+      ./luminox_parse_timing [max cycles per byte, default 100]
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "luminox.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifndef LUMINOX_PROFILING
+#error "build the timing harness with -DLUMINOX_PROFILING"
+#endif
+
+#define LUMINOX_TIMING_REPEATS 128
+#define LUMINOX_TIMING_PERCENTILE 95 // of the repeats, the slowest are left to preemption and interrupts
+#define LUMINOX_TIMING_RANDOM_INPUTS 20000
+
+volatile bool luminox_complete_uart_rx; // only used by the blocking luminox_wait_for_response()
+
+static luminox_handler_t luminox_handler;
+
+static void luminox_timing_tx(unsigned char * request, uint8_t size) {
+    (void)request;
+    (void)size;
+}
+
+// time stamp counter where there is one, nanoseconds stand in for cycles elsewhere, the profiler handles wrap
+static uint32_t luminox_timing_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return (uint32_t)__rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec);
+#endif
+}
+
+static int luminox_timing_compare(const void * a, const void * b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+    @return LUMINOX_TIMING_PERCENTILE of LUMINOX_TIMING_REPEATS runs of luminox_process_response() over the input,
+	    in cycles
+*/
+static uint32_t luminox_timing_measure(const uint8_t * input, uint8_t size) {
+    uint32_t runs[LUMINOX_TIMING_REPEATS];
+    for(int i = 0; i < LUMINOX_TIMING_REPEATS; i++) {
+        luminox_reset_profile(&luminox_handler);
+        luminox_update_data((uint8_t *)input, size, &luminox_handler);
+        luminox_process_response(&luminox_handler);
+        runs[i] = luminox_get_profile(LUMINOX_PROFILE_PROCESS_RESPONSE, &luminox_handler)->max;
+    }
+    qsort(runs, LUMINOX_TIMING_REPEATS, sizeof(runs[0]), luminox_timing_compare);
+    return runs[(LUMINOX_TIMING_REPEATS - 1) * LUMINOX_TIMING_PERCENTILE / 100];
+}
+
+static double luminox_timing_worst;
+static char luminox_timing_worst_name[64];
+
+static void luminox_timing_run(const char * name, const uint8_t * input, uint8_t size) {
+    double per_byte = (double)luminox_timing_measure(input, size) / (size > 0 ? size : 1);
+    if(per_byte > luminox_timing_worst) {
+        luminox_timing_worst = per_byte;
+        snprintf(luminox_timing_worst_name, sizeof(luminox_timing_worst_name), "%s", name);
+    }
+}
+
+static void luminox_timing_fill(uint8_t * input, const char * pattern) {
+    size_t length = strlen(pattern);
+    for(int i = 0; i < UART_RX_BUF_SIZE; i++) {
+        input[i] = (uint8_t)pattern[i % length];
+    }
+}
+
+int main(int argc, char ** argv) {
+    double bound = (argc > 1) ? atof(argv[1]) : 100.0;
+    uint8_t input[UART_RX_BUF_SIZE];
+
+    luminox_handler.luminox_tx = luminox_timing_tx;
+    luminox_handler.luminox_get_cycles = luminox_timing_cycles;
+    luminox_set_spike_filter(LUMINOX_FIELD_PPO2, 1.0f, 8, &luminox_handler);
+    luminox_track_quantile(LUMINOX_FIELD_O2, 0.99f, &luminox_handler);
+
+    const char * frame = "O 0213.1 T +21.3 P 1013 % 020.92 e 0000\r\n";
+    luminox_timing_run("valid frame", (const uint8_t *)frame, (uint8_t)strlen(frame));
+
+    static const char * const patterns[] = {
+        "O ", "% ", "T ", "P ", "e ", "# ", "M ", "E ", "O 0213.1 ", "P ------ ", "0000000000", "          ", "O",
+    };
+    for(size_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+        luminox_timing_fill(input, patterns[i]);
+        luminox_timing_run(patterns[i], input, UART_RX_BUF_SIZE); // no terminator
+        input[UART_RX_BUF_SIZE - 1] = TERMINATOR;
+        luminox_timing_run(patterns[i], input, UART_RX_BUF_SIZE);
+    }
+
+    srand(1);
+    for(int i = 0; i < LUMINOX_TIMING_RANDOM_INPUTS; i++) {
+        static const char alphabet[] = "O%TPe#ME -+.0123456789\r\n";
+        for(int k = 0; k < UART_RX_BUF_SIZE; k++) {
+            input[k] = (uint8_t)alphabet[rand() % (sizeof(alphabet) - 1)];
+        }
+        luminox_timing_run("random", input, UART_RX_BUF_SIZE);
+    }
+
+    printf("worst case %.1f cycles per byte (%s), bound %.1f\n", luminox_timing_worst, luminox_timing_worst_name, bound);
+    return (luminox_timing_worst > bound) ? 1 : 0;
+}
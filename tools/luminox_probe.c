@@ -0,0 +1,151 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Probe Tool
+
+  @File Name
+    luminox_probe.c
+
+  @Summary
+    Finds LuminOx sensors on the serial ports of a Linux host
+
+  @Description
+    Opens every serial port given on the command line, or every /dev/ttyUSB*, /dev/ttyACM* and /dev/ttyS* if none
+    are given, and probes all of them at once with luminox_probe_start() from a single poll() loop. Prints the
+    identity, status and measurements of each LuminOx sensor found, so a whole rack takes about as long as one sensor.
+      cc -std=c99 -O2 -I../src luminox_probe.c luminox_serial.c ../src/luminox.c -o luminox_probe
+      ./luminox_probe [/dev/ttyUSB0 ...]
+******************************************************************************/
+
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <glob.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "luminox.h"
+#include "luminox_serial.h"
+
+#define LUMINOX_PROBE_MAX_PORTS 64
+
+volatile bool luminox_complete_uart_rx; // only used by the blocking luminox_wait_for_response()
+
+typedef struct {
+    const char * path;
+    int fd;
+    luminox_handler_t luminox;
+} luminox_probe_port_t;
+
+static luminox_probe_port_t ports[LUMINOX_PROBE_MAX_PORTS];
+static int port_count;
+static luminox_probe_port_t * current_port; // port whose handler is calling luminox_tx
+static char port_paths[LUMINOX_PROBE_MAX_PORTS][64];
+
+// luminox_tx has no context argument, so current_port is set before every call into the driver
+static void luminox_probe_tx(unsigned char * request, uint8_t size) {
+    if(write(current_port->fd, request, size) != size) {
+        fprintf(stderr, "%s: short write\n", current_port->path);
+    }
+}
+
+static void luminox_probe_add(const char * path) {
+    if(port_count >= LUMINOX_PROBE_MAX_PORTS) {
+        fprintf(stderr, "%s: more than %d ports, skipped\n", path, LUMINOX_PROBE_MAX_PORTS);
+        return;
+    }
+    int fd = luminox_serial_open(path);
+    if(fd < 0) {
+        return;
+    }
+    luminox_probe_port_t * port = &ports[port_count];
+    snprintf(port_paths[port_count], sizeof(port_paths[0]), "%s", path);
+    port->path = port_paths[port_count];
+    port->fd = fd;
+    port->luminox.luminox_tx = luminox_probe_tx;
+    port->luminox.luminox_get_time = luminox_serial_time;
+    port_count++;
+}
+
+static void luminox_probe_discover(void) {
+    static const char * const patterns[] = { "/dev/ttyUSB*", "/dev/ttyACM*", "/dev/ttyS*" };
+    for(size_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+        glob_t found;
+        if(glob(patterns[i], 0, NULL, &found) == 0) {
+            for(size_t k = 0; k < found.gl_pathc; k++) {
+                luminox_probe_add(found.gl_pathv[k]);
+            }
+        }
+        globfree(&found);
+    }
+}
+
+static void luminox_probe_print(luminox_probe_port_t * port) {
+    luminox_handler_t * luminox = &port->luminox;
+    if(luminox_sequence_result(luminox) != LUMINOX_SUCCESS) {
+        printf("%-16s no LuminOx sensor (%d)\n", port->path, luminox_sequence_result(luminox));
+        return;
+    }
+    const luminox_identity_t * identity = luminox_get_identity(luminox);
+    printf("%-16s serial %s status %u ppO2 %.1f mbar O2 %.2f %% T %.1f C",
+           port->path, identity->serial_number, luminox_get_sensor_status(luminox),
+           luminox_get_ppO2(luminox), luminox_get_O2(luminox), luminox_get_temp(luminox));
+    if(luminox_barometric_pressure_valid(luminox)) {
+        printf(" P %.0f mbar", luminox_get_barometric_pressure(luminox));
+    }
+    printf("\n");
+}
+
+int main(int argc, char ** argv) {
+    static struct pollfd fds[LUMINOX_PROBE_MAX_PORTS];
+    if(argc > 1) {
+        for(int i = 1; i < argc; i++) {
+            luminox_probe_add(argv[i]);
+        }
+    } else {
+        luminox_probe_discover();
+    }
+    if(port_count == 0) {
+        fprintf(stderr, "no serial ports to probe\n");
+        return 1;
+    }
+
+    uint32_t start = luminox_serial_time();
+    for(int i = 0; i < port_count; i++) {
+        current_port = &ports[i];
+        luminox_probe_start(&ports[i].luminox);
+        fds[i].fd = ports[i].fd;
+        fds[i].events = POLLIN;
+    }
+
+    bool busy = true;
+    while(busy) {
+        if(poll(fds, (nfds_t)port_count, 10) < 0 && errno != EINTR) {
+            perror("poll");
+            return 1;
+        }
+        busy = false;
+        for(int i = 0; i < port_count; i++) {
+            current_port = &ports[i];
+            if(fds[i].revents & POLLIN) {
+                uint8_t buf[64];
+                ssize_t n = read(ports[i].fd, buf, sizeof(buf));
+                for(ssize_t k = 0; k < n; k++) {
+                    if(luminox_receive_byte(buf[k], &ports[i].luminox)) {
+                        luminox_process_response(&ports[i].luminox); // sends the next request of the probe
+                    }
+                }
+            }
+            if(luminox_sequence_busy(&ports[i].luminox)) {
+                busy = true;
+            }
+        }
+    }
+
+    for(int i = 0; i < port_count; i++) {
+        luminox_probe_print(&ports[i]);
+        close(ports[i].fd);
+    }
+    printf("probed %d ports in %u ms\n", port_count, luminox_serial_time() - start);
+    return 0;
+}
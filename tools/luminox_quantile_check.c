@@ -0,0 +1,171 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Quantile Check
+
+  @File Name
+    luminox_quantile_check.c
+
+  @Summary
+    Checks luminox_get_quantile() against the error bound documented in luminox.h
+
+  @Description
+    Feeds responses of several signal shapes (noise, drift, sine, sorted runs, sawtooth, a step, two modes,
+    a reading stuck on few values, an outlier, temperature around 0 C) through luminox_process_response() and
+    compares p1, p5, p50, p95 and p99 with the exact nearest rank quantiles of the values the driver decoded.
+    Fails if a result is further than half a bin width from the exact quantile, if the bins widened although the
+    values fit in LUMINOX_QUANTILE_BINS reading steps, or if a bin is wider than 2 * span / (LUMINOX_QUANTILE_BINS - 1).
+      cc -O2 -I../src luminox_quantile_check.c ../src/luminox.c -o luminox_quantile_check -lm
+      ./luminox_quantile_check
+******************************************************************************/
+
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "luminox.h"
+
+#define LUMINOX_CHECK_MAX_VALUES 28800 // an eight hour shift at 1 Hz
+#define LUMINOX_CHECK_SHORT_VALUES 300 // five minutes at 1 Hz
+
+volatile bool luminox_complete_uart_rx; // only used by the blocking luminox_wait_for_response()
+
+typedef enum {
+    LUMINOX_SIGNAL_NOISE = 0,
+    LUMINOX_SIGNAL_DRIFT,
+    LUMINOX_SIGNAL_SINE,
+    LUMINOX_SIGNAL_ASCENDING,
+    LUMINOX_SIGNAL_DESCENDING,
+    LUMINOX_SIGNAL_SAWTOOTH,
+    LUMINOX_SIGNAL_STEP,
+    LUMINOX_SIGNAL_BIMODAL,
+    LUMINOX_SIGNAL_STUCK,
+    LUMINOX_SIGNAL_OUTLIER,
+    LUMINOX_SIGNAL_FROST, // temperature, negative reading steps
+    LUMINOX_SIGNAL_COUNT
+} luminox_signal_t;
+
+static const char * const signal_names[LUMINOX_SIGNAL_COUNT] = {
+    "noise", "drift", "sine", "ascending", "descending", "sawtooth", "step", "bimodal", "stuck", "outlier", "frost",
+};
+static const float quantiles[] = { 0.01f, 0.05f, 0.5f, 0.95f, 0.99f };
+
+static luminox_handler_t luminox_handler;
+static float decoded[LUMINOX_CHECK_MAX_VALUES];
+static uint32_t random_state;
+
+static void luminox_check_tx(unsigned char * request, uint8_t size) {
+    (void)request;
+    (void)size;
+}
+
+// uniform in [0, 1), fixed seed so every run checks the same values
+static float luminox_check_random(void) {
+    random_state = random_state * 1664525u + 1013904223u;
+    return (float)(random_state >> 8) / 16777216.0f;
+}
+
+// approximately normal with the given spread, sum of uniforms
+static float luminox_check_noise(float sigma) {
+    float sum = 0;
+    for(int i = 0; i < 12; i++) {
+        sum += luminox_check_random();
+    }
+    return (sum - 6.0f) * sigma;
+}
+
+static float luminox_check_signal(luminox_signal_t signal, uint32_t i, uint32_t count) {
+    float t = (float)i / (float)count;
+    switch(signal) {
+        case LUMINOX_SIGNAL_NOISE:
+            return 20.9f + luminox_check_noise(0.3f);
+        case LUMINOX_SIGNAL_DRIFT:
+            return 20.9f - 1.5f * t + luminox_check_noise(0.05f);
+        case LUMINOX_SIGNAL_SINE:
+            return 20.9f + 1.0f * sinf(2.0f * 3.14159265f * 4.0f * t);
+        case LUMINOX_SIGNAL_ASCENDING:
+            return 15.0f + 10.0f * t;
+        case LUMINOX_SIGNAL_DESCENDING:
+            return 25.0f - 10.0f * t;
+        case LUMINOX_SIGNAL_SAWTOOTH:
+            return 19.0f + 4.0f * fmodf(10.0f * t, 1.0f);
+        case LUMINOX_SIGNAL_STEP:
+            return ((t < 0.5f) ? 20.9f : 18.0f) + luminox_check_noise(0.1f);
+        case LUMINOX_SIGNAL_BIMODAL:
+            return ((luminox_check_random() < 0.7f) ? 20.9f : 16.0f) + luminox_check_noise(0.2f);
+        case LUMINOX_SIGNAL_STUCK:
+            return 20.9f + 0.01f * (float)(int)(luminox_check_random() * 4.0f); // four distinct readings
+        case LUMINOX_SIGNAL_OUTLIER:
+            return (i == count / 3) ? 95.0f : 20.9f + luminox_check_noise(0.02f);
+        default:
+            return -2.0f + 3.0f * t + luminox_check_noise(0.4f);
+    }
+}
+
+static int luminox_check_compare(const void * a, const void * b) {
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+    @return Number of bound violations after count values of the signal
+*/
+static int luminox_check_run(luminox_signal_t signal, uint32_t count) {
+    const bool temperature = (signal == LUMINOX_SIGNAL_FROST);
+    const luminox_field_t field = temperature ? LUMINOX_FIELD_TEMP : LUMINOX_FIELD_O2;
+    const float resolution = temperature ? 0.1f : 0.01f;
+
+    memset(&luminox_handler, 0, sizeof(luminox_handler));
+    luminox_handler.luminox_tx = luminox_check_tx;
+    luminox_track_quantile(field, 0.99f, &luminox_handler);
+    random_state = 1;
+    for(uint32_t i = 0; i < count; i++) {
+        char response[16];
+        float value = luminox_check_signal(signal, i, count);
+        int length = temperature ? snprintf(response, sizeof(response), "T %+05.1f\r\n", value)
+                                 : snprintf(response, sizeof(response), "%% %06.2f\r\n", value);
+        luminox_update_data((uint8_t *)response, (uint8_t)length, &luminox_handler);
+        luminox_process_response(&luminox_handler);
+        decoded[i] = temperature ? luminox_get_temp(&luminox_handler) : luminox_get_O2(&luminox_handler);
+    }
+    qsort(decoded, count, sizeof(decoded[0]), luminox_check_compare);
+
+    int failures = 0;
+    const luminox_quantile_t * quantile = &luminox_handler.quantiles[0];
+    double width = (double)((uint32_t)1 << quantile->shift); // reading steps
+    double span = round((decoded[count - 1] - decoded[0]) / resolution);
+    bool narrow = (span < LUMINOX_QUANTILE_BINS) ? (width == 1) : (width < 2 * span / (LUMINOX_QUANTILE_BINS - 1));
+    if(!narrow) {
+        printf("%s, %u values: bins %.0f steps wide for a span of %.0f steps\n", signal_names[signal], count, width, span);
+        failures++;
+    }
+    for(size_t q = 0; q < sizeof(quantiles) / sizeof(quantiles[0]); q++) {
+        float estimate;
+        if(luminox_get_quantile(field, quantiles[q], &estimate, &luminox_handler) != LUMINOX_SUCCESS) {
+            printf("%s, %u values: p%.0f not available\n", signal_names[signal], count, 100 * quantiles[q]);
+            failures++;
+            continue;
+        }
+        uint32_t rank = (uint32_t)ceil((double)quantiles[q] * count); // nearest rank, 1 based
+        double error = fabs((double)estimate - decoded[rank - 1]) / resolution;
+        if(error > (width - 1) / 2 + 0.01) { // 0.01 steps of float rounding
+            printf("%s, %u values: p%.0f off by %.2f steps, bound %.1f\n", signal_names[signal], count,
+                100 * quantiles[q], error, (width - 1) / 2);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+int main(void) {
+    static const uint32_t counts[] = { LUMINOX_CHECK_SHORT_VALUES, LUMINOX_CHECK_MAX_VALUES };
+    int failures = 0;
+    for(size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        for(int s = 0; s < LUMINOX_SIGNAL_COUNT; s++) {
+            failures += luminox_check_run((luminox_signal_t)s, counts[c]);
+        }
+    }
+    printf("%d quantiles outside the bound\n", failures);
+    return (failures > 0) ? 1 : 0;
+}
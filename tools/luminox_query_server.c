@@ -0,0 +1,255 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Query Server
+
+  @File Name
+    luminox_query_server.c
+
+  @Summary
+    Serves the state of LuminOx sensors to local clients over Unix domain sockets
+
+  @Description
+    Owns the serial ports of the sensors given on the command line and answers many clients from the same poll()
+    loop that reads the sensors, so acquisition never waits for a client. The sensors are brought up with
+    luminox_init_start() and then switched to streaming mode.
+
+    SOCKET is a SOCK_SEQPACKET socket, every message is one query: the index of the sensor in the command line
+    (0 for the first) followed by a query of luminox_query.h. The answer is the response of luminox_query_handle().
+    SOCKET.metrics is a SOCK_STREAM socket that writes the luminox_query_metrics() of every sensor and closes.
+      cc -std=c99 -O2 -DLUMINOX_HISTORY -I../src luminox_query_server.c luminox_serial.c ../src/luminox.c ../src/luminox_query.c
+      ./luminox_query_server /run/luminox.sock /dev/ttyUSB0 [/dev/ttyUSB1 ...]
+******************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "luminox.h"
+#include "luminox_query.h"
+#include "luminox_serial.h"
+
+#define LUMINOX_SERVER_MAX_SENSORS 32
+#define LUMINOX_SERVER_MAX_CLIENTS 64
+#define LUMINOX_SERVER_RESPONSE_SIZE 4096 // room for 178 history samples
+#define LUMINOX_SERVER_METRICS_SIZE 1024 // per sensor
+
+volatile bool luminox_complete_uart_rx; // only used by the blocking luminox_wait_for_response()
+
+typedef struct {
+    const char * path;
+    int fd;
+    bool streaming; // initialized and switched to streaming mode
+    luminox_handler_t luminox;
+} luminox_server_sensor_t;
+
+static luminox_server_sensor_t sensors[LUMINOX_SERVER_MAX_SENSORS];
+static int sensor_count;
+static luminox_server_sensor_t * current_sensor; // sensor whose handler is calling luminox_tx
+static int clients[LUMINOX_SERVER_MAX_CLIENTS];
+static int client_count;
+
+// luminox_tx has no context argument, so current_sensor is set before every call into the driver
+static void luminox_server_tx(unsigned char * request, uint8_t size) {
+    if(write(current_sensor->fd, request, size) != size) {
+        fprintf(stderr, "%s: short write\n", current_sensor->path);
+    }
+}
+
+/*
+    @brief Function for creating a listening Unix domain socket, replacing a stale one
+
+    @return File descriptor, -1 on error
+*/
+static int luminox_server_listen(const char * path, int type) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "%s: path too long\n", path);
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+    int fd = socket(AF_UNIX, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    unlink(path);
+    if(bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, 16) != 0) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*
+    @brief Function for answering one query message of a client
+
+    @return false if the client disconnected
+*/
+static bool luminox_server_query(int client) {
+    uint8_t request[64];
+    uint8_t response[LUMINOX_SERVER_RESPONSE_SIZE];
+    uint16_t response_size;
+    ssize_t size = recv(client, request, sizeof(request), MSG_DONTWAIT);
+    if(size == 0 || (size < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        return false;
+    }
+    if(size < 0) {
+        return true;
+    }
+    if(size < 2 || request[0] >= sensor_count) {
+        response[0] = (size >= 2) ? request[1] : 0;
+        response[1] = (uint8_t)LUMINOX_ERR_INVALID_ARG; // no such sensor
+        response_size = LUMINOX_QUERY_HEADER_SIZE;
+    } else {
+        luminox_query_handle(&request[1], (uint16_t)(size - 1), response, sizeof(response), &response_size,
+                             &sensors[request[0]].luminox);
+    }
+    return send(client, response, response_size, MSG_DONTWAIT | MSG_NOSIGNAL) == response_size;
+}
+
+/*
+    @brief Function for writing the metrics of every sensor to a scraper and closing the connection
+*/
+static void luminox_server_metrics(int listener) {
+    static char text[LUMINOX_SERVER_METRICS_SIZE * LUMINOX_SERVER_MAX_SENSORS];
+    int client = accept4(listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if(client < 0) {
+        return;
+    }
+    size_t length = 0;
+    for(int i = 0; i < sensor_count; i++) {
+        int written = luminox_query_metrics(&text[length], LUMINOX_SERVER_METRICS_SIZE, &sensors[i].luminox);
+        if(written > 0) {
+            length += (written < LUMINOX_SERVER_METRICS_SIZE) ? (size_t)written : LUMINOX_SERVER_METRICS_SIZE - 1;
+        }
+    }
+    if(send(client, text, length, MSG_DONTWAIT | MSG_NOSIGNAL) != (ssize_t)length) {
+        fprintf(stderr, "metrics: scraper too slow, truncated\n");
+    }
+    close(client);
+}
+
+/*
+    @brief Function for reading the bytes a sensor sent and driving its handler
+*/
+static void luminox_server_sensor(luminox_server_sensor_t * sensor) {
+    uint8_t buf[64];
+    ssize_t n = read(sensor->fd, buf, sizeof(buf));
+    current_sensor = sensor;
+    for(ssize_t k = 0; k < n; k++) {
+        if(luminox_receive_byte(buf[k], &sensor->luminox)) {
+            luminox_process_response(&sensor->luminox);
+        }
+    }
+}
+
+/*
+    @brief Function for switching every sensor whose initialization finished to streaming mode
+*/
+static void luminox_server_start_streaming(void) {
+    for(int i = 0; i < sensor_count; i++) {
+        luminox_server_sensor_t * sensor = &sensors[i];
+        current_sensor = sensor;
+        if(sensor->streaming || luminox_sequence_busy(&sensor->luminox)) {
+            continue;
+        }
+        if(luminox_sequence_result(&sensor->luminox) != LUMINOX_SUCCESS) {
+            fprintf(stderr, "%s: initialization failed (%d), retrying\n", sensor->path, luminox_sequence_result(&sensor->luminox));
+            luminox_init_start(&sensor->luminox);
+            continue;
+        }
+        // the "M 00" answer arrives later and is handled by the receive loop like the streamed responses
+        luminox_set_ouput_mode(LUMINOX_MODE_STREAMING, &sensor->luminox);
+        sensor->streaming = true;
+    }
+}
+
+int main(int argc, char ** argv) {
+    static struct pollfd fds[LUMINOX_SERVER_MAX_SENSORS + 2 + LUMINOX_SERVER_MAX_CLIENTS];
+    static char metrics_path[sizeof(((struct sockaddr_un *)0)->sun_path) + 8];
+    if(argc < 3) {
+        fprintf(stderr, "usage: %s SOCKET TTY...\n", argv[0]);
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    for(int i = 2; i < argc && sensor_count < LUMINOX_SERVER_MAX_SENSORS; i++) {
+        luminox_server_sensor_t * sensor = &sensors[sensor_count];
+        sensor->fd = luminox_serial_open(argv[i]);
+        if(sensor->fd < 0) {
+            perror(argv[i]);
+            return 1;
+        }
+        sensor->path = argv[i];
+        sensor->luminox.luminox_tx = luminox_server_tx;
+        sensor->luminox.luminox_get_time = luminox_serial_time;
+        current_sensor = sensor;
+        luminox_init_start(&sensor->luminox);
+        sensor_count++;
+    }
+
+    snprintf(metrics_path, sizeof(metrics_path), "%s.metrics", argv[1]);
+    int query_listener = luminox_server_listen(argv[1], SOCK_SEQPACKET);
+    int metrics_listener = luminox_server_listen(metrics_path, SOCK_STREAM);
+    if(query_listener < 0 || metrics_listener < 0) {
+        return 1;
+    }
+
+    for(;;) {
+        // sensors first, then the two listeners, then the clients
+        int count = 0;
+        for(int i = 0; i < sensor_count; i++) {
+            fds[count].fd = sensors[i].fd;
+            fds[count++].events = POLLIN;
+        }
+        fds[count].fd = query_listener;
+        fds[count++].events = POLLIN;
+        fds[count].fd = metrics_listener;
+        fds[count++].events = POLLIN;
+        for(int i = 0; i < client_count; i++) {
+            fds[count].fd = clients[i];
+            fds[count++].events = POLLIN;
+        }
+
+        if(poll(fds, (nfds_t)count, 100) < 0 && errno != EINTR) {
+            perror("poll");
+            return 1;
+        }
+
+        for(int i = 0; i < sensor_count; i++) {
+            if(fds[i].revents & POLLIN) {
+                luminox_server_sensor(&sensors[i]);
+            }
+        }
+        luminox_server_start_streaming();
+
+        // clients only read the handlers, so serving them never delays a sensor
+        int first_client = sensor_count + 2;
+        for(int i = client_count - 1; i >= 0; i--) {
+            if((fds[first_client + i].revents & (POLLIN | POLLHUP | POLLERR)) && !luminox_server_query(clients[i])) {
+                close(clients[i]);
+                clients[i] = clients[--client_count];
+            }
+        }
+        if(fds[sensor_count].revents & POLLIN) {
+            int client = accept4(query_listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if(client >= 0 && client_count < LUMINOX_SERVER_MAX_CLIENTS) {
+                clients[client_count++] = client;
+            } else if(client >= 0) {
+                close(client); // full, the client sees the connection closed
+            }
+        }
+        if(fds[sensor_count + 1].revents & POLLIN) {
+            luminox_server_metrics(metrics_listener);
+        }
+    }
+}
@@ -0,0 +1,194 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Replay Check
+
+  @File Name
+    luminox_replay_check.c
+
+  @Summary
+    Records a simulated day of polling and checks that luminox_replay() reproduces it
+
+  @Description
+    Polls a simulated sensor once a second for a day of virtual time with the luminox_capture callback recording
+    every transfer, then replays the capture into a fresh handler. Fails if any decoded value, timestamp or response
+    latency differs from the live run, if the replay takes longer than the bound in seconds, or if the mean cost of
+    luminox_process_response() exceeds the bound in microseconds. The mean is checked rather than the maximum,
+    which on a host includes whatever preempted the process. With -t the replay's trace events are written
+    for luminox_trace2json.
+      cc -O2 -DLUMINOX_PROFILING -I../src luminox_replay_check.c ../src/luminox.c -o luminox_replay_check
+      ./luminox_replay_check [-t trace.txt] [max replay seconds, default 5] [max mean us per frame, default 20]
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "luminox.h"
+
+#ifndef LUMINOX_PROFILING
+#error "build the replay check with -DLUMINOX_PROFILING"
+#endif
+
+#define LUMINOX_CHECK_FRAMES 86400 // a day at one poll per second
+#define LUMINOX_CHECK_POOL_SIZE (LUMINOX_CHECK_FRAMES * 48) // request and response bytes of every frame
+
+volatile bool luminox_complete_uart_rx; // only used by the blocking luminox_wait_for_response()
+
+// @brief what the subscriber saw of one decoded response
+typedef struct {
+    float ppo2;
+    float o2;
+    float temp;
+    float barometric_pressure;
+    uint32_t timestamp;
+    uint32_t latency;
+} luminox_check_frame_t;
+
+typedef struct {
+    luminox_handler_t * handler;
+    luminox_check_frame_t * frames;
+    uint32_t count;
+} luminox_check_run_t;
+
+static luminox_handler_t live;
+static luminox_handler_t replayed;
+static luminox_check_frame_t live_frames[LUMINOX_CHECK_FRAMES];
+static luminox_check_frame_t replayed_frames[LUMINOX_CHECK_FRAMES];
+static luminox_capture_record_t records[2 * LUMINOX_CHECK_FRAMES];
+static uint32_t record_count;
+static uint8_t pool[LUMINOX_CHECK_POOL_SIZE];
+static uint32_t pool_used;
+static uint32_t virtual_time;
+static FILE * trace_file;
+
+static uint32_t luminox_check_time(void) {
+    return virtual_time;
+}
+
+static uint64_t luminox_check_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static uint32_t luminox_check_cycles(void) {
+    return (uint32_t)luminox_check_ns(); // nanoseconds stand in for cycles
+}
+
+// the simulated sensor answers after the request and response took their time on the line
+static void luminox_check_tx(unsigned char * request, uint8_t size) {
+    char response[64];
+    (void)request;
+    float ppo2 = 213.0f + 5.0f * sinf((float)virtual_time / 600000.0f);
+    int length = snprintf(response, sizeof(response), "O %06.1f T %+05.1f P %04d %% %06.2f e 0000\r\n",
+                          ppo2, 21.3f + (float)(virtual_time / 1000 % 50) / 10.0f, 1013, ppo2 / 10.13f);
+    virtual_time += (uint32_t)((size + length) * LUMINOX_BITS_PER_BYTE * 1000 / LUMINOX_BAUDRATE) + 5;
+    luminox_update_data((uint8_t *)response, (uint8_t)length, &live);
+}
+
+static void luminox_check_capture(const luminox_capture_record_t * record, void * context) {
+    (void)context;
+    if(record_count >= sizeof(records) / sizeof(records[0]) || pool_used + record->size > sizeof(pool)) {
+        fprintf(stderr, "capture storage full\n");
+        exit(1);
+    }
+    memcpy(&pool[pool_used], record->data, record->size);
+    records[record_count] = *record;
+    records[record_count++].data = &pool[pool_used];
+    pool_used += record->size;
+}
+
+static void luminox_check_subscriber(const luminox_sample_t * sample, void * context) {
+    luminox_check_run_t * run = context;
+    if(run->count >= LUMINOX_CHECK_FRAMES) {
+        return;
+    }
+    luminox_check_frame_t * frame = &run->frames[run->count++];
+    frame->ppo2 = sample->ppo2;
+    frame->o2 = sample->o2;
+    frame->temp = sample->temp;
+    frame->barometric_pressure = sample->barometric_pressure;
+    frame->timestamp = sample->timestamp;
+    frame->latency = luminox_get_response_latency(run->handler);
+}
+
+static void luminox_check_trace(luminox_trace_event_t event, void * context) {
+    (void)context;
+    fprintf(trace_file, "%llu 1 %d\n", (unsigned long long)(luminox_check_ns() / 1000), (int)event);
+}
+
+int main(int argc, char ** argv) {
+    int arg = 1;
+    if(argc > 2 && strcmp(argv[1], "-t") == 0) {
+        trace_file = fopen(argv[2], "w");
+        if(trace_file == NULL) {
+            perror(argv[2]);
+            return 1;
+        }
+        arg = 3;
+    }
+    double max_seconds = (argc > arg) ? atof(argv[arg]) : 5.0;
+    double max_us = (argc > arg + 1) ? atof(argv[arg + 1]) : 20.0;
+    luminox_check_run_t live_run = { &live, live_frames, 0 };
+    luminox_check_run_t replayed_run = { &replayed, replayed_frames, 0 };
+
+    // record
+    live.luminox_tx = luminox_check_tx;
+    live.luminox_get_time = luminox_check_time;
+    live.luminox_capture = luminox_check_capture;
+    luminox_subscribe(luminox_check_subscriber, &live_run, LUMINOX_FIELD_ALL, &live);
+    for(uint32_t i = 0; i < LUMINOX_CHECK_FRAMES; i++) {
+        virtual_time = i * 1000;
+        luminox_request_all(&live);
+    }
+
+    // replay
+    replayed.luminox_tx = luminox_check_tx; // never called while replaying
+    replayed.luminox_get_cycles = luminox_check_cycles;
+    if(trace_file != NULL) {
+        replayed.luminox_trace = luminox_check_trace;
+    }
+    luminox_subscribe(luminox_check_subscriber, &replayed_run, LUMINOX_FIELD_ALL, &replayed);
+    uint64_t start = luminox_check_ns();
+    luminox_retcode_t ret = luminox_replay(records, record_count, &replayed);
+    double seconds = (double)(luminox_check_ns() - start) / 1e9;
+    const luminox_profile_stat_t * profile = luminox_get_profile(LUMINOX_PROFILE_PROCESS_RESPONSE, &replayed);
+    if(trace_file != NULL) {
+        fclose(trace_file);
+    }
+
+    int failures = 0;
+    if(ret != LUMINOX_SUCCESS) {
+        printf("replay returned %d\n", ret);
+        failures++;
+    }
+    if(live_run.count != LUMINOX_CHECK_FRAMES || replayed_run.count != live_run.count) {
+        printf("decoded %u live and %u replayed frames, expected %u\n", live_run.count, replayed_run.count, LUMINOX_CHECK_FRAMES);
+        failures++;
+    }
+    for(uint32_t i = 0; i < live_run.count && i < replayed_run.count; i++) {
+        if(memcmp(&live_frames[i], &replayed_frames[i], sizeof(luminox_check_frame_t)) != 0) {
+            printf("frame %u differs: ppO2 %.1f/%.1f timestamp %u/%u latency %u/%u\n", i, live_frames[i].ppo2,
+                   replayed_frames[i].ppo2, live_frames[i].timestamp, replayed_frames[i].timestamp,
+                   live_frames[i].latency, replayed_frames[i].latency);
+            failures++;
+            break;
+        }
+    }
+
+    double mean_us = (profile->count > 0) ? (double)profile->total / profile->count / 1000.0 : 0;
+    printf("replayed %u frames (%u records) in %.3f s, process_response mean %.2f us max %.2f us\n",
+           replayed_run.count, record_count, seconds, mean_us, profile->max / 1000.0);
+    if(seconds > max_seconds) {
+        printf("replay slower than %.1f s\n", max_seconds);
+        failures++;
+    }
+    if(mean_us > max_us) {
+        printf("mean cost per frame above %.1f us\n", max_us);
+        failures++;
+    }
+    return (failures > 0) ? 1 : 0;
+}
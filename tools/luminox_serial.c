@@ -0,0 +1,63 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Serial Port Helpers
+
+  @File Name
+    luminox_serial.c
+
+  @Summary
+    Linux serial port and clock helpers shared by the host tools
+
+  @Description
+    Implements functions that open a tty the way the LuminOx sensor expects and provide a millisecond clock
+    for luminox_get_time
+******************************************************************************/
+
+#define _DEFAULT_SOURCE
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "luminox_serial.h"
+
+/*
+    @brief Function for opening a serial port at 9600 baud, 8N1, raw and non-blocking
+
+    @param[in] path Device, e.g. /dev/ttyUSB0
+
+    @return File descriptor, -1 if the port can't be opened or is not a tty
+*/
+int luminox_serial_open(const char * path) {
+    int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if(fd < 0) {
+        return -1;
+    }
+    struct termios tty;
+    if(tcgetattr(fd, &tty) != 0) {
+        close(fd); // not a tty
+        return -1;
+    }
+    cfmakeraw(&tty);
+    cfsetispeed(&tty, B9600);
+    cfsetospeed(&tty, B9600);
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cflag &= ~(CSTOPB | CRTSCTS);
+    if(tcsetattr(fd, TCSANOW, &tty) != 0) {
+        close(fd);
+        return -1;
+    }
+    tcflush(fd, TCIOFLUSH);
+    return fd;
+}
+
+/*
+    @brief Function for getting a monotonic millisecond time, for luminox_get_time
+
+    @return Milliseconds since an arbitrary point, wraps like the driver expects
+*/
+uint32_t luminox_serial_time(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000u + (uint64_t)now.tv_nsec / 1000000u);
+}
@@ -0,0 +1,37 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Serial Port Helpers
+
+  @File Name
+    luminox_serial.h
+
+  @Summary
+    Linux serial port and clock helpers shared by the host tools
+
+  @Description
+    Declares functions that open a tty the way the LuminOx sensor expects and provide a millisecond clock
+    for luminox_get_time
+******************************************************************************/
+
+#ifndef LUMINOX_SERIAL_H
+#define LUMINOX_SERIAL_H
+
+#include <stdint.h>
+
+/*
+    @brief Function for opening a serial port at 9600 baud, 8N1, raw and non-blocking
+
+    @param[in] path Device, e.g. /dev/ttyUSB0
+
+    @return File descriptor, -1 if the port can't be opened or is not a tty
+*/
+int luminox_serial_open(const char * path);
+
+/*
+    @brief Function for getting a monotonic millisecond time, for luminox_get_time
+
+    @return Milliseconds since an arbitrary point, wraps like the driver expects
+*/
+uint32_t luminox_serial_time(void);
+
+
+#endif // LUMINOX_SERIAL_H
@@ -0,0 +1,80 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Trace Converter
+
+  @File Name
+    luminox_trace2json.c
+
+  @Summary
+    Converts logged trace events to Chrome trace JSON
+
+  @Description
+    Reads one event per line as written by a luminox_trace callback on the host,
+      fprintf(log, "%llu %d %d\n", timestamp_us, sensor, (int)event);
+    and writes a Chrome trace for chrome://tracing or Perfetto with one thread per sensor. Fails on unknown events
+    and on spans that end without having started, so a broken trace is caught rather than drawn.
+      cc -std=c99 -O2 -I../src luminox_trace2json.c ../src/luminox.c -o luminox_trace2json
+      ./luminox_trace2json [trace.txt] > trace.json
+******************************************************************************/
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "luminox.h"
+
+#define LUMINOX_TRACE_MAX_SENSORS 256
+#define LUMINOX_TRACE_MAX_DEPTH 8
+
+volatile bool luminox_complete_uart_rx; // only used by the blocking luminox_wait_for_response()
+
+// open spans of each sensor, innermost last
+static luminox_trace_event_t open_spans[LUMINOX_TRACE_MAX_SENSORS][LUMINOX_TRACE_MAX_DEPTH];
+static uint8_t depth[LUMINOX_TRACE_MAX_SENSORS];
+
+int main(int argc, char ** argv) {
+    FILE * input = stdin;
+    if(argc > 1 && (input = fopen(argv[1], "r")) == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    unsigned long long timestamp;
+    int sensor;
+    int event;
+    unsigned long line = 0;
+    int matched;
+    printf("{\"traceEvents\":[\n");
+    while((matched = fscanf(input, "%llu %d %d", &timestamp, &sensor, &event)) == 3) {
+        line++;
+        if(sensor < 0 || sensor >= LUMINOX_TRACE_MAX_SENSORS || event < 0 || event > LUMINOX_TRACE_DISPATCH_END) {
+            fprintf(stderr, "line %lu: unknown sensor %d or event %d\n", line, sensor, event);
+            return 1;
+        }
+        luminox_trace_event_t trace_event = (luminox_trace_event_t)event;
+        const char * name = luminox_trace_event_name(trace_event);
+        if(luminox_trace_event_phase(trace_event) == 'B') {
+            if(depth[sensor] >= LUMINOX_TRACE_MAX_DEPTH) {
+                fprintf(stderr, "line %lu: spans of sensor %d nested too deep\n", line, sensor);
+                return 1;
+            }
+            open_spans[sensor][depth[sensor]++] = trace_event;
+        } else if(depth[sensor] == 0 || strcmp(luminox_trace_event_name(open_spans[sensor][--depth[sensor]]), name) != 0) {
+            fprintf(stderr, "line %lu: %s of sensor %d ends a span it didn't start\n", line, name, sensor);
+            return 1;
+        }
+        printf("%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu,\"pid\":1,\"tid\":%d}", (line > 1) ? ",\n" : "",
+               name, luminox_trace_event_phase(trace_event), timestamp, sensor);
+    }
+    if(matched != EOF) {
+        fprintf(stderr, "line %lu: expected \"timestamp_us sensor event\"\n", line + 1);
+        return 1;
+    }
+    printf("\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    for(int i = 0; i < LUMINOX_TRACE_MAX_SENSORS; i++) {
+        if(depth[i] > 0) {
+            fprintf(stderr, "sensor %d: %s span never ended\n", i, luminox_trace_event_name(open_spans[i][depth[i] - 1]));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,227 @@
+"""Python binding for the SST Sensing LuminOx O2 sensor driver.
+
+Wraps the C driver through ctypes. Build the library first (``make`` in tools/),
+or point LUMINOX_PY_LIB at a libluminox_py.so built with your own LUMINOX_* options.
+
+The history ring and decoded capture columns are exposed through the buffer
+protocol without copying, so ``numpy.asarray(handler.history("ppo2")[0])`` or
+``numpy.frombuffer(columns["o2"], dtype=numpy.float32)`` views the driver's memory.
+"""
+
+import array
+import ctypes
+import os
+import select
+import termios
+import time
+
+_lib = ctypes.CDLL(os.environ.get("LUMINOX_PY_LIB",
+                                  os.path.join(os.path.dirname(os.path.abspath(__file__)), "libluminox_py.so")))
+
+_TX = ctypes.CFUNCTYPE(None, ctypes.POINTER(ctypes.c_ubyte), ctypes.c_uint8)
+_GET_TIME = ctypes.CFUNCTYPE(ctypes.c_uint32)
+_handler = ctypes.c_void_p
+
+
+def _declare(name, restype, *argtypes):
+    function = getattr(_lib, name)
+    function.restype = restype
+    function.argtypes = list(argtypes)
+
+
+_declare("luminox_py_handler_size", ctypes.c_size_t)
+_declare("luminox_py_success", ctypes.c_int)
+_declare("luminox_py_history_size", ctypes.c_uint16)
+_declare("luminox_py_set_callbacks", None, _TX, _GET_TIME, _handler)
+_declare("luminox_py_history_column", ctypes.c_void_p, ctypes.c_int, _handler)
+_declare("luminox_get_history", ctypes.c_void_p, _handler)
+_declare("luminox_history_segments", None, ctypes.c_void_p, ctypes.c_void_p)
+_declare("luminox_py_decode_capture", ctypes.c_uint32, ctypes.c_char_p, ctypes.c_uint32, ctypes.c_void_p,
+         ctypes.c_void_p, ctypes.c_void_p, ctypes.c_void_p, ctypes.c_void_p, ctypes.c_uint32, _handler)
+_declare("luminox_init_start", ctypes.c_int, _handler)
+_declare("luminox_probe_start", ctypes.c_int, _handler)
+_declare("luminox_sequence_busy", ctypes.c_bool, _handler)
+_declare("luminox_sequence_result", ctypes.c_int, _handler)
+_declare("luminox_request", ctypes.c_int, ctypes.c_int, _handler)
+_declare("luminox_update_data", None, ctypes.c_char_p, ctypes.c_uint8, _handler)
+_declare("luminox_receive_byte", ctypes.c_bool, ctypes.c_uint8, _handler)
+_declare("luminox_process_response", None, _handler)
+_declare("luminox_get_ppO2", ctypes.c_float, _handler)
+_declare("luminox_get_O2", ctypes.c_float, _handler)
+_declare("luminox_get_temp", ctypes.c_float, _handler)
+_declare("luminox_get_barometric_pressure", ctypes.c_float, _handler)
+_declare("luminox_barometric_pressure_valid", ctypes.c_bool, _handler)
+_declare("luminox_get_sensor_status", ctypes.c_uint16, _handler)
+_declare("luminox_get_identity", ctypes.c_void_p, _handler)
+
+SUCCESS = _lib.luminox_py_success()
+HISTORY_SIZE = _lib.luminox_py_history_size()
+INFO_SIZE = 12  # LUMINOX_INFO_SIZE
+
+# luminox_command_t
+COMMAND_ALL, COMMAND_PPO2, COMMAND_O2, COMMAND_TEMP, COMMAND_BAROMETRIC_PRESSURE, COMMAND_SENSOR_STATUS = range(6)
+
+# luminox_py_column_t, with the array typecode of each column
+_COLUMNS = {
+    "ppo2": (0, "f"),
+    "o2": (1, "f"),
+    "temp": (2, "f"),
+    "barometric_pressure": (3, "f"),
+    "status": (4, "H"),
+    "timestamp": (5, "I"),
+    "fields": (6, "B"),
+}
+
+
+class Handler:
+    """One luminox_handler_t, owned by Python. Requests are written to transport.write()."""
+
+    def __init__(self, transport=None):
+        self._memory = ctypes.create_string_buffer(_lib.luminox_py_handler_size())  # zeroed, hooks start as NULL
+        self._ptr = ctypes.cast(self._memory, ctypes.c_void_p)
+        self.transport = transport
+        self._blocking = False  # True while request() waits inside luminox_tx
+        self._timeout = 1.0
+        self._start = time.monotonic()
+        # keep the callbacks referenced for as long as the handler lives
+        self._tx = _TX(self._on_tx)
+        self._get_time = _GET_TIME(lambda: int((time.monotonic() - self._start) * 1000) & 0xFFFFFFFF)
+        _lib.luminox_py_set_callbacks(self._tx, self._get_time, self._ptr)
+
+    def _on_tx(self, request, size):
+        self.transport.write(ctypes.string_at(request, size))
+        if not self._blocking:
+            return
+        # like the blocking uart_write() in the README, the request functions decode the response right after luminox_tx
+        response = b""
+        deadline = time.monotonic() + self._timeout
+        while b"\n" not in response and time.monotonic() < deadline:
+            response += self.transport.read(0.01)
+        response = response[:response.find(b"\n") + 1] if b"\n" in response else response
+        _lib.luminox_update_data(response[:255], min(len(response), 255), self._ptr)
+
+    def receive(self, data):
+        """Feeds received bytes to the driver, processing every complete response."""
+        for byte in data:
+            if _lib.luminox_receive_byte(byte, self._ptr):
+                _lib.luminox_process_response(self._ptr)
+
+    def run(self, timeout=5.0):
+        """Pumps the transport until the running request sequence ends, returns luminox_sequence_result()."""
+        deadline = time.monotonic() + timeout
+        while _lib.luminox_sequence_busy(self._ptr) and time.monotonic() < deadline:
+            self.receive(self.transport.read(0.01))
+        return _lib.luminox_sequence_result(self._ptr)
+
+    def init(self, timeout=5.0):
+        """Initializes the sensor with luminox_init_start(), returns True on success."""
+        if _lib.luminox_init_start(self._ptr) != SUCCESS:
+            return False
+        return self.run(timeout) == SUCCESS
+
+    def probe(self, timeout=5.0):
+        """Probes the transport with luminox_probe_start(), returns True if a LuminOx sensor answered."""
+        if _lib.luminox_probe_start(self._ptr) != SUCCESS:
+            return False
+        return self.run(timeout) == SUCCESS
+
+    def request(self, command=COMMAND_ALL, timeout=1.0):
+        """Sends a measurement request and waits for its response, returns True if it was decoded."""
+        self._blocking = True
+        self._timeout = timeout
+        try:
+            return _lib.luminox_request(command, self._ptr) == SUCCESS
+        finally:
+            self._blocking = False
+
+    @property
+    def ppo2(self):
+        return _lib.luminox_get_ppO2(self._ptr)
+
+    @property
+    def o2(self):
+        return _lib.luminox_get_O2(self._ptr)
+
+    @property
+    def temp(self):
+        return _lib.luminox_get_temp(self._ptr)
+
+    @property
+    def barometric_pressure(self):
+        """Barometric pressure in mbar, None if the sensor has no pressure sensor or didn't report it."""
+        if not _lib.luminox_barometric_pressure_valid(self._ptr):
+            return None
+        return _lib.luminox_get_barometric_pressure(self._ptr)
+
+    @property
+    def status(self):
+        return _lib.luminox_get_sensor_status(self._ptr)
+
+    @property
+    def identity(self):
+        """(date of manufacture, serial number, software version) as decoded from the "#" responses."""
+        raw = ctypes.string_at(_lib.luminox_get_identity(self._ptr), 3 * INFO_SIZE)
+        return tuple(raw[i * INFO_SIZE:(i + 1) * INFO_SIZE].split(b"\0")[0].decode("ascii", "replace")
+                     for i in range(3))
+
+    def history_column(self, name):
+        """Memoryview of all HISTORY_SIZE entries of a history column, pointing into the handler."""
+        index, typecode = _COLUMNS[name]
+        ctype = {"f": ctypes.c_float, "H": ctypes.c_uint16, "I": ctypes.c_uint32, "B": ctypes.c_uint8}[typecode]
+        address = _lib.luminox_py_history_column(index, self._ptr)
+        return memoryview((ctype * HISTORY_SIZE).from_address(address)).cast("B").cast(typecode)
+
+    def history(self, name):
+        """Oldest to newest samples of a history column as two memoryview slices, see luminox_history_segments()."""
+        column = self.history_column(name)
+        segments = (ctypes.c_uint16 * 4)()  # two luminox_history_segment_t
+        _lib.luminox_history_segments(_lib.luminox_get_history(self._ptr), segments)
+        return (column[segments[0]:segments[0] + segments[1]], column[segments[2]:segments[2] + segments[3]])
+
+    def decode_capture(self, data, capacity=None):
+        """Decodes a capture of raw received bytes in one call, returns a dict of array.array columns."""
+        if capacity is None:
+            capacity = data.count(b"\n")
+        columns = {name: array.array(typecode, bytes(capacity * array.array(typecode).itemsize))
+                   for name, (_, typecode) in _COLUMNS.items() if name not in ("timestamp", "fields")}
+        rows = _lib.luminox_py_decode_capture(
+            bytes(data), len(data), *(columns[name].buffer_info()[0] for name in
+                                      ("ppo2", "o2", "temp", "barometric_pressure", "status")),
+            capacity, self._ptr)
+        for column in columns.values():
+            del column[rows:]
+        return columns
+
+
+class SerialTransport:
+    """Linux serial port at 9600 baud, 8N1, raw and non-blocking."""
+
+    def __init__(self, path):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+        attributes = termios.tcgetattr(self.fd)
+        attributes[0] = 0  # iflag
+        attributes[1] = 0  # oflag
+        attributes[2] = termios.CS8 | termios.CREAD | termios.CLOCAL  # cflag
+        attributes[3] = 0  # lflag
+        attributes[4] = attributes[5] = termios.B9600
+        termios.tcsetattr(self.fd, termios.TCSANOW, attributes)
+        termios.tcflush(self.fd, termios.TCIOFLUSH)
+
+    def fileno(self):
+        return self.fd
+
+    def write(self, data):
+        os.write(self.fd, data)
+
+    def read(self, timeout):
+        """Returns the bytes received within timeout seconds, b"" if none."""
+        ready, _, _ = select.select([self.fd], [], [], timeout)
+        if not ready:
+            return b""
+        try:
+            return os.read(self.fd, 256)
+        except BlockingIOError:
+            return b""
+
+    def close(self):
+        os.close(self.fd)
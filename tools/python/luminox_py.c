@@ -0,0 +1,128 @@
+/* ****************************************************************************/
+/** SST Sensing LuminOx O2 Sensor Python Binding Support
+
+  @File Name
+    luminox_py.c
+
+  @Summary
+    Helpers the Python binding needs on top of the driver API
+
+  @Description
+    Built together with luminox.c into libluminox_py.so, which luminox.py loads with ctypes. Exposes the size of
+    the handler, so Python can own its memory, the history columns, so they can be wrapped without copying, and a
+    bulk decoder that turns a whole capture into columns in one call.
+      cc -std=c99 -O2 -shared -fPIC -DLUMINOX_HISTORY -I../../src luminox_py.c ../../src/luminox.c -o libluminox_py.so
+******************************************************************************/
+
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "luminox.h"
+
+#ifndef LUMINOX_HISTORY
+#error "the Python binding exposes the history ring, build it with -DLUMINOX_HISTORY"
+#endif
+
+volatile bool luminox_complete_uart_rx; // only used by the blocking luminox_wait_for_response()
+
+// @brief columns of luminox_history_t, see luminox_py_history_column()
+typedef enum {
+    LUMINOX_PY_COLUMN_PPO2 = 0,
+    LUMINOX_PY_COLUMN_O2,
+    LUMINOX_PY_COLUMN_TEMP,
+    LUMINOX_PY_COLUMN_BAROMETRIC_PRESSURE,
+    LUMINOX_PY_COLUMN_STATUS,
+    LUMINOX_PY_COLUMN_TIMESTAMP,
+    LUMINOX_PY_COLUMN_FIELDS
+} luminox_py_column_t;
+
+size_t luminox_py_handler_size(void) {
+    return sizeof(luminox_handler_t);
+}
+
+luminox_retcode_t luminox_py_success(void) {
+    return LUMINOX_SUCCESS;
+}
+
+uint16_t luminox_py_history_size(void) {
+    return LUMINOX_HISTORY_SIZE;
+}
+
+void luminox_py_set_callbacks(void (*tx)(unsigned char * request, uint8_t size), uint32_t (*get_time)(void),
+                              luminox_handler_t * luminox_handler) {
+    luminox_handler->luminox_tx = tx;
+    luminox_handler->luminox_get_time = get_time;
+}
+
+/*
+    @brief Function for getting one column of the history ring
+
+    @return Pointer to the LUMINOX_HISTORY_SIZE entries of the column, NULL for an unknown column
+*/
+const void * luminox_py_history_column(luminox_py_column_t column, luminox_handler_t * luminox_handler) {
+    const luminox_history_t * history = luminox_get_history(luminox_handler);
+    switch(column) {
+        case LUMINOX_PY_COLUMN_PPO2:
+            return history->ppo2;
+        case LUMINOX_PY_COLUMN_O2:
+            return history->o2;
+        case LUMINOX_PY_COLUMN_TEMP:
+            return history->temp;
+        case LUMINOX_PY_COLUMN_BAROMETRIC_PRESSURE:
+            return history->barometric_pressure;
+        case LUMINOX_PY_COLUMN_STATUS:
+            return history->status;
+        case LUMINOX_PY_COLUMN_TIMESTAMP:
+            return history->timestamp;
+        case LUMINOX_PY_COLUMN_FIELDS:
+            return history->fields;
+    }
+    return NULL;
+}
+
+/*
+    @brief Function for decoding a capture of responses into columns
+
+    @note The capture is the raw bytes received from the sensor. Each response is passed through
+	  luminox_update_data() and luminox_process_response(), so subscribers and history see it as usual.
+	  Every response that updated a measurement becomes one row, fields it didn't update are NAN, or 0 for the status.
+
+    @param[in] data Captured bytes
+
+    @param[in] size Number of captured bytes
+
+    @param[out] ppo2, o2, temp, barometric_pressure, status Columns of at least capacity entries
+
+    @param[in] capacity Number of rows the columns can hold
+
+    @return Number of rows written, decoding stops when the columns are full
+*/
+uint32_t luminox_py_decode_capture(const uint8_t * data, uint32_t size, float * ppo2, float * o2, float * temp,
+                                   float * barometric_pressure, uint16_t * status, uint32_t capacity,
+                                   luminox_handler_t * luminox_handler) {
+    uint32_t rows = 0;
+    uint32_t start = 0;
+    for(uint32_t i = 0; i < size && rows < capacity; i++) {
+        if(data[i] != TERMINATOR) {
+            continue;
+        }
+        uint32_t length = i + 1 - start;
+        luminox_update_data((uint8_t *)&data[start], (length > UART_RX_BUF_SIZE) ? UART_RX_BUF_SIZE : (uint8_t)length,
+                            luminox_handler);
+        luminox_process_response(luminox_handler);
+        start = i + 1;
+
+        const luminox_sample_t * sample = &luminox_handler->sample;
+        if(luminox_handler->err_code != LUMINOX_SUCCESS || sample->fields == 0) {
+            continue;
+        }
+        ppo2[rows] = (sample->fields & LUMINOX_FIELD_PPO2) ? sample->ppo2 : NAN;
+        o2[rows] = (sample->fields & LUMINOX_FIELD_O2) ? sample->o2 : NAN;
+        temp[rows] = (sample->fields & LUMINOX_FIELD_TEMP) ? sample->temp : NAN;
+        barometric_pressure[rows] = (sample->fields & LUMINOX_FIELD_BAROMETRIC_PRESSURE) ? sample->barometric_pressure : NAN;
+        status[rows] = (sample->fields & LUMINOX_FIELD_STATUS) ? sample->status : 0;
+        rows++;
+    }
+    return rows;
+}
@@ -0,0 +1,120 @@
+"""Simulated SST Sensing LuminOx O2 sensors.
+
+SimulatedSensor answers requests the way a LuminOx sensor does. SimulatedTransport
+connects one to a luminox.Handler in the same process. Run as a script to serve
+sensors on pseudo terminals for luminox_probe or luminox.SerialTransport:
+
+    python3 luminox_sim.py 4
+"""
+
+import os
+import pty
+import random
+import select
+import sys
+import time
+import tty
+
+
+class SimulatedSensor:
+    """A LuminOx sensor with slowly drifting readings, optionally without a barometric pressure sensor."""
+
+    def __init__(self, serial=1, barometric=True, seed=None):
+        self.serial = serial
+        self.barometric = barometric
+        self.mode = 0  # streaming, like a sensor after power up
+        self.random = random.Random(seed)
+        self.ppo2 = 213.0
+        self.o2 = 20.9
+        self.temp = 21.3
+        self.pressure = 1013
+
+    def step(self):
+        """Moves the readings on by one sample."""
+        self.ppo2 += self.random.uniform(-0.5, 0.5)
+        self.o2 = self.ppo2 / self.pressure * 100
+        self.temp += self.random.uniform(-0.05, 0.05)
+
+    def _field(self, letter):
+        if letter == "O":
+            return "O %06.1f" % self.ppo2
+        if letter == "%":
+            return "%% %06.2f" % self.o2
+        if letter == "T":
+            return "T %+05.1f" % self.temp
+        if letter == "P":
+            return "P %04d" % self.pressure if self.barometric else "P ------"
+        return "e 0000"
+
+    def stream(self):
+        """Returns the next streamed response, as sent about once a second in streaming mode."""
+        self.step()
+        return (" ".join(self._field(letter) for letter in "OTP%e") + "\r\n").encode("ascii")
+
+    def respond(self, request):
+        """Returns the response to one request, e.g. b"O\\r\\n", including its terminator."""
+        request = request.decode("ascii", "replace").strip()
+        if not request:
+            return b"E 01\r\n"
+        command, argument = request[0], request[2:]
+        if command == "M" and argument in ("0", "1", "2"):
+            self.mode = int(argument)
+            response = "M 0" + argument
+        elif command == "#" and argument in ("0", "1", "2"):
+            response = ["# 02024 00123", "# %05d %05d" % (self.serial // 100000, self.serial % 100000),
+                        "# 00004"][int(argument)]
+        elif command == "A" and not argument:
+            return self.stream()
+        elif command in "O%TPe" and not argument:
+            self.step()
+            response = self._field(command)
+        else:
+            response = "E 01"
+        return (response + "\r\n").encode("ascii")
+
+
+class SimulatedTransport:
+    """Connects a luminox.Handler to a SimulatedSensor, answers every write on the next read."""
+
+    def __init__(self, sensor):
+        self.sensor = sensor
+        self.pending = b""
+
+    def write(self, data):
+        self.pending += self.sensor.respond(data)
+
+    def read(self, timeout):
+        data, self.pending = self.pending, b""
+        return data
+
+
+def serve(count):
+    """Serves count simulated sensors on pseudo terminals until interrupted, streaming ones send every second."""
+    sensors = {}
+    for i in range(count):
+        master, slave = pty.openpty()
+        tty.setraw(slave)
+        sensors[master] = (SimulatedSensor(serial=i + 1, barometric=(i % 2 == 0), seed=i), b"")
+        print(os.ttyname(slave), flush=True)
+    next_stream = time.monotonic() + 1
+    while True:
+        ready, _, _ = select.select(list(sensors), [], [], max(0, next_stream - time.monotonic()))
+        if time.monotonic() >= next_stream:
+            next_stream += 1
+            for master, (sensor, _) in sensors.items():
+                if sensor.mode == 0:
+                    os.write(master, sensor.stream())
+        for master in ready:
+            sensor, received = sensors[master]
+            received += os.read(master, 256)
+            while b"\n" in received:
+                request, received = received.split(b"\n", 1)
+                os.write(master, sensor.respond(request))
+            sensors[master] = (sensor, received)
+
+
+if __name__ == "__main__":
+    try:
+        serve(int(sys.argv[1]) if len(sys.argv) > 1 else 1)
+    except KeyboardInterrupt:
+        pass